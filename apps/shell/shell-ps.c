@@ -56,10 +56,24 @@ PROCESS_THREAD(shell_ps_process, ev, data)
   PROCESS_BEGIN();
 
   shell_output_str(&ps_command, "Processes:", "");
+#if PROCESS_CONF_EVENT_STATS
+  shell_output_str(&ps_command,
+                   "Name (events posted, dropped, queued, max queued)", "");
+#endif /* PROCESS_CONF_EVENT_STATS */
   for(p = PROCESS_LIST(); p != NULL; p = p->next) {
     char namebuf[30];
+#if PROCESS_CONF_EVENT_STATS
+    char statbuf[50];
+#endif /* PROCESS_CONF_EVENT_STATS */
     strncpy(namebuf, PROCESS_NAME_STRING(p), sizeof(namebuf));
+#if PROCESS_CONF_EVENT_STATS
+    snprintf(statbuf, sizeof(statbuf), " %lu %lu %u %u",
+             p->stats.posted, p->stats.dropped,
+             p->stats.queued, p->stats.max_queued);
+    shell_output_str(&ps_command, namebuf, statbuf);
+#else /* PROCESS_CONF_EVENT_STATS */
     shell_output_str(&ps_command, namebuf, "");
+#endif /* PROCESS_CONF_EVENT_STATS */
   }
 
   PROCESS_END();
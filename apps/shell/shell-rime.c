@@ -138,8 +138,8 @@ PROCESS_THREAD(shell_mac_process, ev, data)
 PROCESS_THREAD(shell_packetize_process, ev, data)
 {
   static struct queuebuf *q = NULL;
-  static char *ptr;
-  static int size;
+  char *ptr;
+  int size;
   int len;
   PROCESS_BEGIN();
 
@@ -154,14 +154,18 @@ PROCESS_THREAD(shell_packetize_process, ev, data)
 	shell_output_str(&packetize_command, "packetize: could not allocate packet buffer", "");
 	PROCESS_EXIT();
       }
-      ptr = queuebuf_dataptr(q);
-      size = 0;
     }
     
     input = data;
 
     len = input->len1 + input->len2;
 
+    /* The data of a queuebuf cannot be written directly, so the packet
+       is collected in packetbuf and stored back in the queuebuf */
+    queuebuf_to_packetbuf(q);
+    ptr = packetbuf_dataptr();
+    size = packetbuf_datalen();
+
     if(len + size >= PACKETBUF_SIZE ||
        len  == 0) {
       shell_output(&packetize_command,
@@ -176,7 +180,8 @@ PROCESS_THREAD(shell_packetize_process, ev, data)
     size += input->len1;
     memcpy(ptr + size, input->data2, input->len2);
     size += input->len2;
-    
+    packetbuf_set_datalen(size);
+    queuebuf_update_from_packetbuf(q);
   }
   
   PROCESS_END();
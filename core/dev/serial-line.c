@@ -95,33 +95,45 @@ PROCESS_THREAD(serial_line_process, ev, data)
   ptr = 0;
 
   while(1) {
-    /* Fill application buffer until newline or empty */
-    int c = ringbuf_get(&rxbuf);
-    
-    if(c == -1) {
+    uint8_t *span;
+    unsigned int len, n;
+
+    /* Scan the buffered bytes in place, a contiguous span at a time,
+       and copy them to the application buffer until newline */
+    len = ringbuf_peek(&rxbuf, &span);
+    if(len == 0) {
       /* Buffer empty, wait for poll */
       PROCESS_YIELD();
+      continue;
+    }
+
+    for(n = 0; n < len && span[n] != END; n++);
+    if(n > BUFSIZE - 1 - ptr) {
+      /* Ignore characters that do not fit (wait for EOL) */
+      memcpy(&buf[ptr], span, BUFSIZE - 1 - ptr);
+      ptr = BUFSIZE - 1;
     } else {
-      if(c != END) {
-        if(ptr < BUFSIZE-1) {
-          buf[ptr++] = (uint8_t)c;
-        } else {
-          /* Ignore character (wait for EOL) */
-        }
-      } else {
-        /* Terminate */
-        buf[ptr++] = (uint8_t)'\0';
-
-        /* Broadcast event */
-        process_post(PROCESS_BROADCAST, serial_line_event_message, buf);
-
-        /* Wait until all processes have handled the serial line event */
-        if(PROCESS_ERR_OK ==
-          process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL)) {
-          PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
-        }
-        ptr = 0;
+      memcpy(&buf[ptr], span, n);
+      ptr += n;
+    }
+
+    if(n == len) {
+      ringbuf_consume(&rxbuf, len);
+    } else {
+      ringbuf_consume(&rxbuf, n + 1);
+
+      /* Terminate */
+      buf[ptr++] = (uint8_t)'\0';
+
+      /* Broadcast event */
+      process_post(PROCESS_BROADCAST, serial_line_event_message, buf);
+
+      /* Wait until all processes have handled the serial line event */
+      if(PROCESS_ERR_OK ==
+        process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL)) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
       }
+      ptr = 0;
     }
   }
 
@@ -223,13 +223,8 @@ slip_poll_handler(uint8_t *outbuf, uint16_t blen)
       if(len > blen) {
 	len = 0;
       } else {
-	unsigned i;
-	for(i = begin; i < RX_BUFSIZE; i++) {
-	  *outbuf++ = rxbuf[i];
-	}
-	for(i = 0; i < pkt_end; i++) {
-	  *outbuf++ = rxbuf[i];
-	}
+	memcpy(outbuf, &rxbuf[begin], RX_BUFSIZE - begin);
+	memcpy(outbuf + (RX_BUFSIZE - begin), rxbuf, pkt_end);
       }
     }
 
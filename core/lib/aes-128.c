@@ -64,7 +64,93 @@ static const uint8_t sbox[256] =   {
 0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
 
-static uint8_t round_keys[11][AES_128_KEY_LENGTH];
+#if AES_128_TABLES
+/* SubBytes followed by MixColumns of a byte in the first row of a
+   column; the other rows use the same table rotated */
+static const uint32_t te0[256] = {
+  0xc66363a5UL, 0xf87c7c84UL, 0xee777799UL, 0xf67b7b8dUL,
+  0xfff2f20dUL, 0xd66b6bbdUL, 0xde6f6fb1UL, 0x91c5c554UL,
+  0x60303050UL, 0x02010103UL, 0xce6767a9UL, 0x562b2b7dUL,
+  0xe7fefe19UL, 0xb5d7d762UL, 0x4dababe6UL, 0xec76769aUL,
+  0x8fcaca45UL, 0x1f82829dUL, 0x89c9c940UL, 0xfa7d7d87UL,
+  0xeffafa15UL, 0xb25959ebUL, 0x8e4747c9UL, 0xfbf0f00bUL,
+  0x41adadecUL, 0xb3d4d467UL, 0x5fa2a2fdUL, 0x45afafeaUL,
+  0x239c9cbfUL, 0x53a4a4f7UL, 0xe4727296UL, 0x9bc0c05bUL,
+  0x75b7b7c2UL, 0xe1fdfd1cUL, 0x3d9393aeUL, 0x4c26266aUL,
+  0x6c36365aUL, 0x7e3f3f41UL, 0xf5f7f702UL, 0x83cccc4fUL,
+  0x6834345cUL, 0x51a5a5f4UL, 0xd1e5e534UL, 0xf9f1f108UL,
+  0xe2717193UL, 0xabd8d873UL, 0x62313153UL, 0x2a15153fUL,
+  0x0804040cUL, 0x95c7c752UL, 0x46232365UL, 0x9dc3c35eUL,
+  0x30181828UL, 0x379696a1UL, 0x0a05050fUL, 0x2f9a9ab5UL,
+  0x0e070709UL, 0x24121236UL, 0x1b80809bUL, 0xdfe2e23dUL,
+  0xcdebeb26UL, 0x4e272769UL, 0x7fb2b2cdUL, 0xea75759fUL,
+  0x1209091bUL, 0x1d83839eUL, 0x582c2c74UL, 0x341a1a2eUL,
+  0x361b1b2dUL, 0xdc6e6eb2UL, 0xb45a5aeeUL, 0x5ba0a0fbUL,
+  0xa45252f6UL, 0x763b3b4dUL, 0xb7d6d661UL, 0x7db3b3ceUL,
+  0x5229297bUL, 0xdde3e33eUL, 0x5e2f2f71UL, 0x13848497UL,
+  0xa65353f5UL, 0xb9d1d168UL, 0x00000000UL, 0xc1eded2cUL,
+  0x40202060UL, 0xe3fcfc1fUL, 0x79b1b1c8UL, 0xb65b5bedUL,
+  0xd46a6abeUL, 0x8dcbcb46UL, 0x67bebed9UL, 0x7239394bUL,
+  0x944a4adeUL, 0x984c4cd4UL, 0xb05858e8UL, 0x85cfcf4aUL,
+  0xbbd0d06bUL, 0xc5efef2aUL, 0x4faaaae5UL, 0xedfbfb16UL,
+  0x864343c5UL, 0x9a4d4dd7UL, 0x66333355UL, 0x11858594UL,
+  0x8a4545cfUL, 0xe9f9f910UL, 0x04020206UL, 0xfe7f7f81UL,
+  0xa05050f0UL, 0x783c3c44UL, 0x259f9fbaUL, 0x4ba8a8e3UL,
+  0xa25151f3UL, 0x5da3a3feUL, 0x804040c0UL, 0x058f8f8aUL,
+  0x3f9292adUL, 0x219d9dbcUL, 0x70383848UL, 0xf1f5f504UL,
+  0x63bcbcdfUL, 0x77b6b6c1UL, 0xafdada75UL, 0x42212163UL,
+  0x20101030UL, 0xe5ffff1aUL, 0xfdf3f30eUL, 0xbfd2d26dUL,
+  0x81cdcd4cUL, 0x180c0c14UL, 0x26131335UL, 0xc3ecec2fUL,
+  0xbe5f5fe1UL, 0x359797a2UL, 0x884444ccUL, 0x2e171739UL,
+  0x93c4c457UL, 0x55a7a7f2UL, 0xfc7e7e82UL, 0x7a3d3d47UL,
+  0xc86464acUL, 0xba5d5de7UL, 0x3219192bUL, 0xe6737395UL,
+  0xc06060a0UL, 0x19818198UL, 0x9e4f4fd1UL, 0xa3dcdc7fUL,
+  0x44222266UL, 0x542a2a7eUL, 0x3b9090abUL, 0x0b888883UL,
+  0x8c4646caUL, 0xc7eeee29UL, 0x6bb8b8d3UL, 0x2814143cUL,
+  0xa7dede79UL, 0xbc5e5ee2UL, 0x160b0b1dUL, 0xaddbdb76UL,
+  0xdbe0e03bUL, 0x64323256UL, 0x743a3a4eUL, 0x140a0a1eUL,
+  0x924949dbUL, 0x0c06060aUL, 0x4824246cUL, 0xb85c5ce4UL,
+  0x9fc2c25dUL, 0xbdd3d36eUL, 0x43acacefUL, 0xc46262a6UL,
+  0x399191a8UL, 0x319595a4UL, 0xd3e4e437UL, 0xf279798bUL,
+  0xd5e7e732UL, 0x8bc8c843UL, 0x6e373759UL, 0xda6d6db7UL,
+  0x018d8d8cUL, 0xb1d5d564UL, 0x9c4e4ed2UL, 0x49a9a9e0UL,
+  0xd86c6cb4UL, 0xac5656faUL, 0xf3f4f407UL, 0xcfeaea25UL,
+  0xca6565afUL, 0xf47a7a8eUL, 0x47aeaee9UL, 0x10080818UL,
+  0x6fbabad5UL, 0xf0787888UL, 0x4a25256fUL, 0x5c2e2e72UL,
+  0x381c1c24UL, 0x57a6a6f1UL, 0x73b4b4c7UL, 0x97c6c651UL,
+  0xcbe8e823UL, 0xa1dddd7cUL, 0xe874749cUL, 0x3e1f1f21UL,
+  0x964b4bddUL, 0x61bdbddcUL, 0x0d8b8b86UL, 0x0f8a8a85UL,
+  0xe0707090UL, 0x7c3e3e42UL, 0x71b5b5c4UL, 0xcc6666aaUL,
+  0x904848d8UL, 0x06030305UL, 0xf7f6f601UL, 0x1c0e0e12UL,
+  0xc26161a3UL, 0x6a35355fUL, 0xae5757f9UL, 0x69b9b9d0UL,
+  0x17868691UL, 0x99c1c158UL, 0x3a1d1d27UL, 0x279e9eb9UL,
+  0xd9e1e138UL, 0xebf8f813UL, 0x2b9898b3UL, 0x22111133UL,
+  0xd26969bbUL, 0xa9d9d970UL, 0x078e8e89UL, 0x339494a7UL,
+  0x2d9b9bb6UL, 0x3c1e1e22UL, 0x15878792UL, 0xc9e9e920UL,
+  0x87cece49UL, 0xaa5555ffUL, 0x50282878UL, 0xa5dfdf7aUL,
+  0x038c8c8fUL, 0x59a1a1f8UL, 0x09898980UL, 0x1a0d0d17UL,
+  0x65bfbfdaUL, 0xd7e6e631UL, 0x844242c6UL, 0xd06868b8UL,
+  0x824141c3UL, 0x299999b0UL, 0x5a2d2d77UL, 0x1e0f0f11UL,
+  0x7bb0b0cbUL, 0xa85454fcUL, 0x6dbbbbd6UL, 0x2c16163aUL
+};
+
+#define ROTR8(x)  (((x) >> 8) | ((x) << 24))
+#define ROTR16(x) (((x) >> 16) | ((x) << 16))
+#define ROTR24(x) (((x) >> 24) | ((x) << 8))
+#endif /* AES_128_TABLES */
+
+struct expanded_key {
+  uint8_t key[AES_128_KEY_LENGTH];
+  uint8_t round_keys[11][AES_128_BLOCK_SIZE];
+  uint16_t last_use;
+};
+
+static struct expanded_key expanded_keys[AES_128_KEY_CACHE];
+static uint8_t expanded_keys_num;
+static uint16_t use_count;
+
+/* The round keys of the current key */
+static uint8_t (*round_keys)[AES_128_BLOCK_SIZE] = expanded_keys[0].round_keys;
 
 /*---------------------------------------------------------------------------*/
 /* multiplies by 2 in GF(2) */
@@ -80,7 +166,7 @@ galois_mul2(uint8_t value)
 }
 /*---------------------------------------------------------------------------*/
 static void
-set_key(uint8_t *key)
+expand_key(uint8_t round_keys[][AES_128_BLOCK_SIZE], const uint8_t *key)
 {
   uint8_t i;
   uint8_t j;
@@ -100,6 +186,122 @@ set_key(uint8_t *key)
   }
 }
 /*---------------------------------------------------------------------------*/
+static struct expanded_key *
+get_expanded_key(const uint8_t *key)
+{
+  struct expanded_key *e;
+  struct expanded_key *oldest;
+  uint8_t i;
+  
+  use_count++;
+  oldest = expanded_keys;
+  for(i = 0; i < expanded_keys_num; i++) {
+    e = &expanded_keys[i];
+    if(memcmp(e->key, key, AES_128_KEY_LENGTH) == 0) {
+      e->last_use = use_count;
+      return e;
+    }
+    if((uint16_t)(use_count - e->last_use)
+       > (uint16_t)(use_count - oldest->last_use)) {
+      oldest = e;
+    }
+  }
+  
+  /* Not found, expand the key into a free or the least recently used
+     entry */
+  if(expanded_keys_num < AES_128_KEY_CACHE) {
+    e = &expanded_keys[expanded_keys_num++];
+  } else {
+    e = oldest;
+  }
+  memcpy(e->key, key, AES_128_KEY_LENGTH);
+  expand_key(e->round_keys, key);
+  e->last_use = use_count;
+  return e;
+}
+/*---------------------------------------------------------------------------*/
+const uint8_t *
+aes_128_round_keys(const uint8_t *key)
+{
+  return get_expanded_key(key)->round_keys[0];
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_key(uint8_t *key)
+{
+  round_keys = get_expanded_key(key)->round_keys;
+}
+#if AES_128_TABLES
+/*---------------------------------------------------------------------------*/
+static uint32_t
+load32(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+      | ((uint32_t)p[2] << 8) | p[3];
+}
+/*---------------------------------------------------------------------------*/
+static void
+store32(uint8_t *p, uint32_t v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *state)
+{
+  uint32_t s0, s1, s2, s3;
+  uint32_t t0, t1, t2, t3;
+  uint8_t round;
+  
+  /* round 0 */
+  s0 = load32(state) ^ load32(round_keys[0]);
+  s1 = load32(state + 4) ^ load32(round_keys[0] + 4);
+  s2 = load32(state + 8) ^ load32(round_keys[0] + 8);
+  s3 = load32(state + 12) ^ load32(round_keys[0] + 12);
+  
+  /* SubBytes, ShiftRows, MixColumns and AddRoundKey */
+  for(round = 1; round < 10; round++) {
+    t0 = te0[s0 >> 24] ^ ROTR8(te0[(s1 >> 16) & 0xff])
+        ^ ROTR16(te0[(s2 >> 8) & 0xff]) ^ ROTR24(te0[s3 & 0xff])
+        ^ load32(round_keys[round]);
+    t1 = te0[s1 >> 24] ^ ROTR8(te0[(s2 >> 16) & 0xff])
+        ^ ROTR16(te0[(s3 >> 8) & 0xff]) ^ ROTR24(te0[s0 & 0xff])
+        ^ load32(round_keys[round] + 4);
+    t2 = te0[s2 >> 24] ^ ROTR8(te0[(s3 >> 16) & 0xff])
+        ^ ROTR16(te0[(s0 >> 8) & 0xff]) ^ ROTR24(te0[s1 & 0xff])
+        ^ load32(round_keys[round] + 8);
+    t3 = te0[s3 >> 24] ^ ROTR8(te0[(s0 >> 16) & 0xff])
+        ^ ROTR16(te0[(s1 >> 8) & 0xff]) ^ ROTR24(te0[s2 & 0xff])
+        ^ load32(round_keys[round] + 12);
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+  
+  /* last round skips MixColumns */
+  store32(state, (((uint32_t)sbox[s0 >> 24] << 24)
+      | ((uint32_t)sbox[(s1 >> 16) & 0xff] << 16)
+      | ((uint32_t)sbox[(s2 >> 8) & 0xff] << 8)
+      | sbox[s3 & 0xff]) ^ load32(round_keys[10]));
+  store32(state + 4, (((uint32_t)sbox[s1 >> 24] << 24)
+      | ((uint32_t)sbox[(s2 >> 16) & 0xff] << 16)
+      | ((uint32_t)sbox[(s3 >> 8) & 0xff] << 8)
+      | sbox[s0 & 0xff]) ^ load32(round_keys[10] + 4));
+  store32(state + 8, (((uint32_t)sbox[s2 >> 24] << 24)
+      | ((uint32_t)sbox[(s3 >> 16) & 0xff] << 16)
+      | ((uint32_t)sbox[(s0 >> 8) & 0xff] << 8)
+      | sbox[s1 & 0xff]) ^ load32(round_keys[10] + 8));
+  store32(state + 12, (((uint32_t)sbox[s3 >> 24] << 24)
+      | ((uint32_t)sbox[(s0 >> 16) & 0xff] << 16)
+      | ((uint32_t)sbox[(s1 >> 8) & 0xff] << 8)
+      | sbox[s2 & 0xff]) ^ load32(round_keys[10] + 12));
+}
+#else /* AES_128_TABLES */
+/*---------------------------------------------------------------------------*/
 static void
 encrypt(uint8_t *state)
 {
@@ -169,6 +371,7 @@ encrypt(uint8_t *state)
     }
   }
 }
+#endif /* AES_128_TABLES */
 /*---------------------------------------------------------------------------*/
 void
 aes_128_padded_encrypt(uint8_t *plaintext_and_result, uint8_t plaintext_len)
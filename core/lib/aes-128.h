@@ -51,6 +51,26 @@
 #define AES_128            aes_128_driver
 #endif /* AES_128_CONF */
 
+/* With AES_128_CONF_TABLES, the software driver uses a 1 kilobyte
+   lookup table that combines SubBytes and MixColumns, which is faster
+   on 32-bit processors than the byte-oriented implementation. */
+#ifdef AES_128_CONF_TABLES
+#define AES_128_TABLES     AES_128_CONF_TABLES
+#else /* AES_128_CONF_TABLES */
+#define AES_128_TABLES     0
+#endif /* AES_128_CONF_TABLES */
+
+/* The number of expanded keys kept by aes_128_round_keys(), so that
+   switching between keys, e.g. the pairwise keys of different
+   neighbors, does not expand a key every time. */
+#ifdef AES_128_CONF_KEY_CACHE
+#define AES_128_KEY_CACHE  AES_128_CONF_KEY_CACHE
+#else /* AES_128_CONF_KEY_CACHE */
+#define AES_128_KEY_CACHE  1
+#endif /* AES_128_CONF_KEY_CACHE */
+
+#define AES_128_ROUND_KEYS_LENGTH (11 * AES_128_BLOCK_SIZE)
+
 /**
  * Structure of AES drivers.
  */
@@ -67,6 +87,17 @@ struct aes_128_driver {
   void (* encrypt)(uint8_t *plaintext_and_result);
 };
 
+/**
+ * \brief Expands a key, or looks it up among the recently expanded keys
+ * \return The AES_128_ROUND_KEYS_LENGTH bytes of round keys, which
+ *         remain valid until AES_128_KEY_CACHE other keys have been
+ *         expanded
+ *
+ *         This function is used by the set_key function of software
+ *         AES drivers.
+ */
+const uint8_t *aes_128_round_keys(const uint8_t *key);
+
 /**
  * \brief Pads the plaintext with zeroes before calling AES_128.encrypt
  */
@@ -79,4 +110,7 @@ void aes_128_set_padded_key(uint8_t *key, uint8_t key_len);
 
 extern const struct aes_128_driver AES_128;
 
+/* The software driver, which hardware drivers can fall back to */
+extern const struct aes_128_driver aes_128_driver;
+
 #endif /* AES_H_ */
@@ -55,6 +55,27 @@
 #ifndef CRC16_H_
 #define CRC16_H_
 
+#include "contiki-conf.h"
+
+/**
+ * \brief      The number of lookup tables used by crc16_data()
+ *
+ *             With zero (the default), crc16_data() calls
+ *             crc16_add() for every byte and needs no table. With 1,
+ *             a 512 byte table is used to process one byte at a time.
+ *             With 4 or 8, the data is processed 4 or 8 bytes at a
+ *             time, with 2 or 4 kilobytes of tables ("slicing-by-N").
+ */
+#ifdef CRC16_CONF_SLICES
+#define CRC16_SLICES CRC16_CONF_SLICES
+#else /* CRC16_CONF_SLICES */
+#define CRC16_SLICES 0
+#endif /* CRC16_CONF_SLICES */
+
+#if CRC16_SLICES != 0 && CRC16_SLICES != 1 && CRC16_SLICES != 4 && CRC16_SLICES != 8
+#error "CRC16_CONF_SLICES must be 0, 1, 4 or 8"
+#endif
+
 /**
  * \brief      Update an accumulated CRC16 checksum with one byte.
  * \param b    The byte to be added to the checksum
@@ -82,10 +103,11 @@ unsigned short crc16_add(unsigned char b, unsigned short crc);
  *
  *             This function calculates the CRC16 checksum of a data area.
  *
- *             \note The algorithm used in this implementation is
- *             tailored for a running checksum and does not perform as
- *             well as a table-driven algorithm when checksumming an
- *             entire data block.
+ *             \note Unless CRC16_CONF_SLICES is set, the algorithm
+ *             used in this implementation is tailored for a running
+ *             checksum and does not perform as well as a
+ *             table-driven algorithm when checksumming an entire data
+ *             block.
  */
 unsigned short crc16_data(const unsigned char *data, int datalen,
 			  unsigned short acc);
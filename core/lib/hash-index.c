@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup hashindex
+ * @{
+ */
+
+/**
+ * \file
+ *         Linear-probe hash index
+ */
+
+#include "lib/hash-index.h"
+#include <string.h>
+
+#define MASK(h) ((h)->size - 1)
+
+/*---------------------------------------------------------------------------*/
+static void
+set_slot(struct hash_index *h, unsigned slot, unsigned entry)
+{
+  if(h->wide) {
+    ((uint16_t *)h->slots)[slot] = entry;
+  } else {
+    ((uint8_t *)h->slots)[slot] = entry;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+hash_index_init(struct hash_index *h)
+{
+  memset(h->slots, 0, h->wide ? h->size * sizeof(uint16_t) : h->size);
+}
+/*---------------------------------------------------------------------------*/
+unsigned
+hash_index_get(const struct hash_index *h, unsigned slot)
+{
+  slot &= MASK(h);
+  if(h->wide) {
+    return ((uint16_t *)h->slots)[slot];
+  } else {
+    return ((uint8_t *)h->slots)[slot];
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+hash_index_insert(struct hash_index *h, unsigned entry)
+{
+  unsigned slot;
+
+  slot = h->hash(entry) & MASK(h);
+  while(hash_index_get(h, slot) != 0) {
+    slot = (slot + 1) & MASK(h);
+  }
+  set_slot(h, slot, entry);
+}
+/*---------------------------------------------------------------------------*/
+int
+hash_index_remove(struct hash_index *h, unsigned entry)
+{
+  unsigned hole, slot, home, moved;
+
+  hole = h->hash(entry) & MASK(h);
+  while(hash_index_get(h, hole) != entry) {
+    if(hash_index_get(h, hole) == 0) {
+      /* Not in the index */
+      return 0;
+    }
+    hole = (hole + 1) & MASK(h);
+  }
+
+  /* Move back entries of the probe sequence that would otherwise no
+     longer be reachable from their home slot */
+  slot = hole;
+  while(1) {
+    slot = (slot + 1) & MASK(h);
+    moved = hash_index_get(h, slot);
+    if(moved == 0) {
+      break;
+    }
+    home = h->hash(moved) & MASK(h);
+    if(((slot - home) & MASK(h)) >= ((slot - hole) & MASK(h))) {
+      set_slot(h, hole, moved);
+      hole = slot;
+    }
+  }
+  set_slot(h, hole, 0);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
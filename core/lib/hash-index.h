@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup lib
+ * @{
+ */
+
+/**
+ * \defgroup hashindex Linear-probe hash index
+ * @{
+ *
+ * A hash index maps keys to entries of a statically allocated table,
+ * such as a MEMB() array. Each slot of the index holds the number of
+ * an entry, counting from one, or zero for an empty slot. Collisions
+ * are resolved by linear probing, and removal shifts later entries
+ * back so that no tombstones are needed.
+ *
+ * The index does not know the keys: a callback gives the hash of the
+ * key of an entry, which the index reduces to the home slot of the
+ * entry. The key of an entry must not change while the entry is in
+ * the index. Lookups probe the slots from the home slot of the key
+ * they search for, until they find a matching entry or an empty slot:
+ \code
+for(slot = hash(key); (entry = hash_index_get(&index, slot)) != 0; slot++) {
+  if(key matches entry) {
+    return entry;
+  }
+}
+ \endcode
+ */
+
+/**
+ * \file
+ *         Header file for the linear-probe hash index
+ */
+
+#ifndef HASH_INDEX_H_
+#define HASH_INDEX_H_
+
+#include "contiki-conf.h"
+#include "sys/cc.h"
+
+/**
+ * \brief       Get the hash of the key of an entry
+ * \param entry The entry number, counting from one
+ * \return      The hash of the key of the entry
+ */
+typedef unsigned (*hash_index_hash_t)(unsigned entry);
+
+struct hash_index {
+  void *slots;
+  unsigned short size;
+  unsigned char wide;
+  hash_index_hash_t hash;
+};
+
+/**
+ * Declare a hash index.
+ *
+ * The slots take one byte each if there are fewer than 255 entries,
+ * and two bytes otherwise.
+ *
+ * \param name The name of the hash index.
+ *
+ * \param num The number of entries of the table. Entry numbers run
+ * from 1 to num.
+ *
+ * \param size The number of slots. Must be a power of two, larger
+ * than num.
+ *
+ * \param hash The hash_index_hash_t function that gives the hash of
+ * the key of an entry.
+ */
+#define HASH_INDEX(name, num, size, hash)                               \
+  static uint16_t CC_CONCAT(name,_slots)[((size) * ((num) < 255 ? 1 : 2) + 1) / 2]; \
+  static struct hash_index name = { CC_CONCAT(name,_slots), (size),     \
+                                    (num) >= 255, (hash) }
+
+/**
+ * \brief       Remove all entries from a hash index
+ * \param h     The hash index
+ */
+void hash_index_init(struct hash_index *h);
+
+/**
+ * \brief       Get the entry in a slot of a hash index
+ * \param h     The hash index
+ * \param slot  The slot, which is reduced modulo the size of the index
+ * \return      The entry number, or zero for an empty slot
+ */
+unsigned hash_index_get(const struct hash_index *h, unsigned slot);
+
+/**
+ * \brief       Add an entry to a hash index
+ * \param h     The hash index
+ * \param entry The entry number, counting from one
+ *
+ *              The entry must not be in the index already.
+ */
+void hash_index_insert(struct hash_index *h, unsigned entry);
+
+/**
+ * \brief       Remove an entry from a hash index
+ * \param h     The hash index
+ * \param entry The entry number, counting from one
+ * \retval 1    The entry was removed
+ * \retval 0    The entry was not in the index
+ */
+int hash_index_remove(struct hash_index *h, unsigned entry);
+
+#endif /* HASH_INDEX_H_ */
+
+/** @} */
+/** @} */
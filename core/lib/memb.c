@@ -47,57 +47,139 @@
 #include "contiki.h"
 #include "lib/memb.h"
 
+#if MEMB_CONF_DEBUG
+#include <stdio.h>
+#endif /* MEMB_CONF_DEBUG */
+
+/*---------------------------------------------------------------------------*/
+static int
+block_index(struct memb *m, void *ptr)
+{
+  unsigned long offset;
+
+  if(!memb_inmemb(m, ptr)) {
+    return -1;
+  }
+  offset = (char *)ptr - (char *)m->mem;
+  if(offset % m->size != 0) {
+    return -1;
+  }
+  return offset / m->size;
+}
 /*---------------------------------------------------------------------------*/
 void
 memb_init(struct memb *m)
 {
   memset(m->count, 0, m->num);
   memset(m->mem, 0, m->size * m->num);
+#if MEMB_CONF_FREELIST
+  m->free_head = 0;
+  m->fresh = 0;
+#endif /* MEMB_CONF_FREELIST */
+#if MEMB_CONF_STATS
+  m->used = 0;
+  m->max_used = 0;
+#endif /* MEMB_CONF_STATS */
 }
 /*---------------------------------------------------------------------------*/
 void *
 memb_alloc(struct memb *m)
 {
   int i;
+  char *block;
+#if MEMB_CONF_FREELIST && MEMB_CONF_DEBUG
+  int recycled = m->free_head != 0;
+#endif /* MEMB_CONF_FREELIST && MEMB_CONF_DEBUG */
+
+#if MEMB_CONF_FREELIST
+  if(m->free_head != 0) {
+    /* Take the first block from the free list. */
+    i = m->free_head - 1;
+    m->free_head = m->next[i];
+  } else if(m->fresh < m->num) {
+    /* Take a block that has never been allocated. */
+    i = m->fresh++;
+  } else {
+    return NULL;
+  }
+  block = (char *)m->mem + (i * m->size);
 
+#if MEMB_CONF_DEBUG
+  if(recycled) {
+    int j;
+    for(j = 0; j < m->size; j++) {
+      if((unsigned char)block[j] != MEMB_POISON) {
+	printf("memb: block %p was written to after it was freed\n", block);
+	break;
+      }
+    }
+  }
+#endif /* MEMB_CONF_DEBUG */
+#else /* MEMB_CONF_FREELIST */
   for(i = 0; i < m->num; ++i) {
     if(m->count[i] == 0) {
-      /* If this block was unused, we increase the reference count to
-	 indicate that it now is used and return a pointer to the
-	 memory block. */
-      ++(m->count[i]);
-      return (void *)((char *)m->mem + (i * m->size));
+      break;
     }
   }
+  if(i == m->num) {
+    /* No free block was found, so we return NULL to indicate failure
+       to allocate block. */
+    return NULL;
+  }
+  block = (char *)m->mem + (i * m->size);
+#endif /* MEMB_CONF_FREELIST */
+
+  /* This block was unused, so we increase the reference count to
+     indicate that it now is used and return a pointer to the memory
+     block. */
+  ++(m->count[i]);
+
+#if MEMB_CONF_STATS
+  if(++m->used > m->max_used) {
+    m->max_used = m->used;
+  }
+#endif /* MEMB_CONF_STATS */
 
-  /* No free block was found, so we return NULL to indicate failure to
-     allocate block. */
-  return NULL;
+  return (void *)block;
 }
 /*---------------------------------------------------------------------------*/
 char
 memb_free(struct memb *m, void *ptr)
 {
   int i;
-  char *ptr2;
 
-  /* Walk through the list of blocks and try to find the block to
-     which the pointer "ptr" points to. */
-  ptr2 = (char *)m->mem;
-  for(i = 0; i < m->num; ++i) {
-    
-    if(ptr2 == (char *)ptr) {
-      /* We've found to block to which "ptr" points so we decrease the
-	 reference count and return the new value of it. */
-      if(m->count[i] > 0) {
-	/* Make sure that we don't deallocate free memory. */
-	--(m->count[i]);
-      }
-      return m->count[i];
-    }
-    ptr2 += m->size;
+  /* Find the block to which the pointer "ptr" points from its offset
+     in the block array. */
+  i = block_index(m, ptr);
+  if(i < 0) {
+#if MEMB_CONF_DEBUG
+    printf("memb: %p is not a block of memb %p\n", ptr, m);
+#endif /* MEMB_CONF_DEBUG */
+    return -1;
+  }
+
+  if(m->count[i] == 0) {
+    /* Make sure that we don't deallocate free memory. */
+#if MEMB_CONF_DEBUG
+    printf("memb: block %p of memb %p freed twice\n", ptr, m);
+#endif /* MEMB_CONF_DEBUG */
+    return -1;
+  }
+
+  /* Decrease the reference count and return the new value of it. */
+  if(--(m->count[i]) == 0) {
+#if MEMB_CONF_DEBUG
+    memset(ptr, MEMB_POISON, m->size);
+#endif /* MEMB_CONF_DEBUG */
+#if MEMB_CONF_FREELIST
+    m->next[i] = m->free_head;
+    m->free_head = i + 1;
+#endif /* MEMB_CONF_FREELIST */
+#if MEMB_CONF_STATS
+    m->used--;
+#endif /* MEMB_CONF_STATS */
   }
-  return -1;
+  return m->count[i];
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -110,6 +192,9 @@ memb_inmemb(struct memb *m, void *ptr)
 int
 memb_numfree(struct memb *m)
 {
+#if MEMB_CONF_STATS
+  return m->num - m->used;
+#else /* MEMB_CONF_STATS */
   int i;
   int num_free = 0;
 
@@ -120,5 +205,6 @@ memb_numfree(struct memb *m)
   }
 
   return num_free;
+#endif /* MEMB_CONF_STATS */
 }
 /** @} */
@@ -65,6 +65,61 @@
 
 #include "sys/cc.h"
 
+/**
+ * \brief Keep a free list of memory blocks
+ *
+ * When set, each MEMB() declares an extra array with one unsigned
+ * short per block that links the free blocks together. memb_alloc()
+ * then takes the first free block in constant time instead of
+ * searching for one. Blocks that have never been allocated are handed
+ * out in order, so memb_init() is not needed for the free list to
+ * work.
+ */
+#ifndef MEMB_CONF_FREELIST
+#define MEMB_CONF_FREELIST 0
+#endif /* MEMB_CONF_FREELIST */
+
+/**
+ * \brief Keep usage statistics for each memory block
+ *
+ * When set, every MEMB() keeps track of the number of blocks in use
+ * and the highest number of blocks that have been in use at the same
+ * time. memb_numfree() then runs in constant time.
+ */
+#ifndef MEMB_CONF_STATS
+#define MEMB_CONF_STATS 0
+#endif /* MEMB_CONF_STATS */
+
+/**
+ * \brief Debug memory block usage
+ *
+ * When set, memb_free() reports attempts to free pointers that are
+ * not allocated blocks, including blocks that were already freed, and
+ * fills freed blocks with MEMB_POISON. With MEMB_CONF_FREELIST, a
+ * freed block that has been written to is reported when it is
+ * allocated again.
+ */
+#ifndef MEMB_CONF_DEBUG
+#define MEMB_CONF_DEBUG 0
+#endif /* MEMB_CONF_DEBUG */
+
+#define MEMB_POISON 0xa5
+
+#if MEMB_CONF_FREELIST
+#define MEMB_FREELIST_DECLARE(name, num) \
+        static unsigned short CC_CONCAT(name,_memb_next)[num];
+#define MEMB_FREELIST_INIT(name) , CC_CONCAT(name,_memb_next), 0, 0
+#else /* MEMB_CONF_FREELIST */
+#define MEMB_FREELIST_DECLARE(name, num)
+#define MEMB_FREELIST_INIT(name)
+#endif /* MEMB_CONF_FREELIST */
+
+#if MEMB_CONF_STATS
+#define MEMB_STATS_INIT , 0, 0
+#else /* MEMB_CONF_STATS */
+#define MEMB_STATS_INIT
+#endif /* MEMB_CONF_STATS */
+
 /**
  * Declare a memory block.
  *
@@ -88,16 +143,35 @@ MEMB(connections, struct connection, 16);
  */
 #define MEMB(name, structure, num) \
         static char CC_CONCAT(name,_memb_count)[num]; \
+        MEMB_FREELIST_DECLARE(name, num) \
         static structure CC_CONCAT(name,_memb_mem)[num]; \
         static struct memb name = {sizeof(structure), num, \
                                           CC_CONCAT(name,_memb_count), \
-                                          (void *)CC_CONCAT(name,_memb_mem)}
+                                          (void *)CC_CONCAT(name,_memb_mem) \
+                                          MEMB_FREELIST_INIT(name) \
+                                          MEMB_STATS_INIT}
 
 struct memb {
   unsigned short size;
   unsigned short num;
   char *count;
   void *mem;
+#if MEMB_CONF_FREELIST
+  /* For each free block on the free list, the index of the next free
+     block plus one. */
+  unsigned short *next;
+  /* The index of the first free block plus one, or zero. */
+  unsigned short free_head;
+  /* The number of blocks that have been taken from the unused end of
+     the block array. */
+  unsigned short fresh;
+#endif /* MEMB_CONF_FREELIST */
+#if MEMB_CONF_STATS
+  /** The number of blocks currently in use. */
+  unsigned short used;
+  /** The highest number of blocks in use at the same time. */
+  unsigned short max_used;
+#endif /* MEMB_CONF_STATS */
 };
 
 /**
@@ -124,7 +198,7 @@ void *memb_alloc(struct memb *m);
  *
  * \return The new reference count for the memory block (should be 0
  * if successfully deallocated) or -1 if the pointer "ptr" did not
- * point to a legal memory block.
+ * point to a legal memory block or the block was not allocated.
  */
 char  memb_free(struct memb *m, void *ptr);
 
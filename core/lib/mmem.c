@@ -47,6 +47,7 @@
 #include "mmem.h"
 #include "list.h"
 #include "contiki-conf.h"
+#include "sys/process.h"
 #include <string.h>
 
 #ifdef MMEM_CONF_SIZE
@@ -59,6 +60,16 @@ LIST(mmemlist);
 unsigned int avail_memory;
 static char memory[MMEM_SIZE];
 
+/* The offset of the first byte after the last allocated block. Unless
+   compaction is deferred, this is always MMEM_SIZE - avail_memory. */
+static unsigned int top;
+
+static unsigned long bytes_moved;
+
+#if MMEM_LAZY_COMPACTION && MMEM_COMPACT_SLICE
+PROCESS(mmem_compact_process, "Managed memory compaction");
+#endif /* MMEM_LAZY_COMPACTION && MMEM_COMPACT_SLICE */
+
 /*---------------------------------------------------------------------------*/
 /**
  * \brief      Allocate a managed memory block
@@ -87,19 +98,28 @@ mmem_alloc(struct mmem *m, unsigned int size)
     return 0;
   }
 
+#if MMEM_LAZY_COMPACTION
+  /* There is enough free memory, but it may be spread out over the
+     holes left by freed blocks. If so, compact all of it now. */
+  if(MMEM_SIZE - top < size) {
+    mmem_compact(MMEM_SIZE);
+  }
+#endif /* MMEM_LAZY_COMPACTION */
+
   /* We had enough memory so we add this memory block to the end of
      the list of allocated memory blocks. */
   list_add(mmemlist, m);
 
   /* Set up the pointer so that it points to the first available byte
      in the memory block. */
-  m->ptr = &memory[MMEM_SIZE - avail_memory];
+  m->ptr = &memory[top];
 
   /* Remember the size of this memory block. */
   m->size = size;
 
   /* Decrease the amount of available memory. */
   avail_memory -= size;
+  top += size;
 
   /* Return non-zero to indicate that we were able to allocate
      memory. */
@@ -120,11 +140,39 @@ mmem_free(struct mmem *m)
 {
   struct mmem *n;
 
+#if MMEM_LAZY_COMPACTION
+  struct mmem *prev;
+
+  /* Leave a hole where the block was. The memory is compacted when
+     an allocation does not fit or by the compaction process. */
+  prev = NULL;
+  for(n = list_head(mmemlist); n != NULL && n != m; n = n->next) {
+    prev = n;
+  }
+  if(n == NULL) {
+    return;
+  }
+  if(prev == NULL) {
+    list_pop(mmemlist);
+  } else {
+    prev->next = m->next;
+  }
+  if(m->next == NULL) {
+    /* This was the last block, so the space it used is now at the
+       top of the memory again. */
+    top = prev == NULL ? 0 : (char *)prev->ptr + prev->size - memory;
+  }
+  avail_memory += m->size;
+#if MMEM_COMPACT_SLICE
+  process_poll(&mmem_compact_process);
+#endif /* MMEM_COMPACT_SLICE */
+#else /* MMEM_LAZY_COMPACTION */
   if(m->next != NULL) {
     /* Compact the memory after the allocation that is to be removed
        by moving it downwards. */
     memmove(m->ptr, m->next->ptr,
 	    &memory[MMEM_SIZE - avail_memory] - (char *)m->next->ptr);
+    bytes_moved += &memory[MMEM_SIZE - avail_memory] - (char *)m->next->ptr;
     
     /* Update all the memory pointers that points to memory that is
        after the allocation that is to be removed. */
@@ -134,9 +182,84 @@ mmem_free(struct mmem *m)
   }
 
   avail_memory += m->size;
+  top -= m->size;
 
   /* Remove the memory block from the list. */
   list_remove(mmemlist, m);
+#endif /* MMEM_LAZY_COMPACTION */
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Compact the managed memory
+ * \param max  The largest number of bytes to move
+ * \return     Non-zero if there are holes left to compact, zero
+ *             otherwise.
+ *
+ *             This function moves allocated blocks downwards to fill
+ *             the holes left by freed blocks, until about \c max bytes
+ *             have been moved. Blocks are always moved whole, and at
+ *             least one block is moved if there is a hole. It only
+ *             has an effect when MMEM_CONF_LAZY_COMPACTION is set.
+ *
+ */
+int
+mmem_compact(unsigned int max)
+{
+  struct mmem *n;
+  char *end;
+  unsigned int moved;
+
+  moved = 0;
+  end = memory;
+  for(n = list_head(mmemlist); n != NULL; n = n->next) {
+    if((char *)n->ptr != end) {
+      if(moved > 0 && moved + n->size > max) {
+	break;
+      }
+      memmove(end, n->ptr, n->size);
+      n->ptr = end;
+      moved += n->size;
+    }
+    end = (char *)n->ptr + n->size;
+  }
+  bytes_moved += moved;
+
+  if(n == NULL) {
+    /* All blocks are now packed at the bottom of the memory. */
+    top = end - memory;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Get statistics about the managed memory
+ * \param stats A pointer to the structure that is filled in
+ *
+ *             This function reports the number of free bytes, the
+ *             size of the largest free area and the total number of
+ *             bytes that compaction has moved so far.
+ *
+ */
+void
+mmem_stats(struct mmem_stats *stats)
+{
+  struct mmem *n;
+  char *end;
+  unsigned int hole;
+
+  stats->free = avail_memory;
+  stats->bytes_moved = bytes_moved;
+  stats->largest_free = MMEM_SIZE - top;
+
+  end = memory;
+  for(n = list_head(mmemlist); n != NULL; n = n->next) {
+    hole = (char *)n->ptr - end;
+    if(hole > stats->largest_free) {
+      stats->largest_free = hole;
+    }
+    end = (char *)n->ptr + n->size;
+  }
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -157,8 +280,31 @@ mmem_init(void)
   }
   list_init(mmemlist);
   avail_memory = MMEM_SIZE;
+  top = 0;
   inited = 1;
+#if MMEM_LAZY_COMPACTION && MMEM_COMPACT_SLICE
+  process_start(&mmem_compact_process, NULL);
+#endif /* MMEM_LAZY_COMPACTION && MMEM_COMPACT_SLICE */
+}
+/*---------------------------------------------------------------------------*/
+#if MMEM_LAZY_COMPACTION && MMEM_COMPACT_SLICE
+PROCESS_THREAD(mmem_compact_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    /* Move at most one slice per poll, so that other processes get
+       to run in between. */
+    if(mmem_compact(MMEM_COMPACT_SLICE)) {
+      process_poll(&mmem_compact_process);
+    }
+  }
+
+  PROCESS_END();
 }
+#endif /* MMEM_LAZY_COMPACTION && MMEM_COMPACT_SLICE */
 /*---------------------------------------------------------------------------*/
 
 /** @} */
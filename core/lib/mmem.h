@@ -59,6 +59,40 @@
 #ifndef MMEM_H_
 #define MMEM_H_
 
+/**
+ * \brief Defer compaction of the managed memory
+ *
+ * By default, mmem_free() compacts the memory immediately by moving
+ * all blocks after the freed one, which takes time proportional to
+ * the amount of allocated memory. When MMEM_CONF_LAZY_COMPACTION is
+ * set, mmem_free() only leaves a hole. The holes are compacted when
+ * an allocation does not fit at the top of the memory, when
+ * mmem_compact() is called, or in the background as described for
+ * MMEM_CONF_COMPACT_SLICE.
+ *
+ * Allocated memory may then also move in mmem_alloc() and whenever
+ * the compaction process runs, so MMEM_PTR() must be used again after
+ * a process has yielded.
+ */
+#ifdef MMEM_CONF_LAZY_COMPACTION
+#define MMEM_LAZY_COMPACTION MMEM_CONF_LAZY_COMPACTION
+#else /* MMEM_CONF_LAZY_COMPACTION */
+#define MMEM_LAZY_COMPACTION 0
+#endif /* MMEM_CONF_LAZY_COMPACTION */
+
+/**
+ * \brief Bytes moved per run of the background compaction process
+ *
+ * With deferred compaction, a process compacts the memory after
+ * mmem_free() has been called, moving about this many bytes each time
+ * it is polled. Zero disables the process.
+ */
+#ifdef MMEM_CONF_COMPACT_SLICE
+#define MMEM_COMPACT_SLICE MMEM_CONF_COMPACT_SLICE
+#else /* MMEM_CONF_COMPACT_SLICE */
+#define MMEM_COMPACT_SLICE 128
+#endif /* MMEM_CONF_COMPACT_SLICE */
+
 /*---------------------------------------------------------------------------*/
 /**
  * \brief      Get a pointer to the managed memory
@@ -83,9 +117,23 @@ struct mmem {
 /* XXX: tagga minne med "interrupt usage", vilke gr att man r
    speciellt varsam under free(). */
 
+/**
+ * Statistics about the managed memory, as returned by mmem_stats().
+ */
+struct mmem_stats {
+  /** The total number of free bytes. */
+  unsigned int free;
+  /** The size of the largest contiguous free area. */
+  unsigned int largest_free;
+  /** The number of bytes that compaction has moved so far. */
+  unsigned long bytes_moved;
+};
+
 int  mmem_alloc(struct mmem *m, unsigned int size);
 void mmem_free(struct mmem *);
 void mmem_init(void);
+int  mmem_compact(unsigned int max);
+void mmem_stats(struct mmem_stats *stats);
 
 #endif /* MMEM_H_ */
 
@@ -38,9 +38,10 @@
  */
 
 #include "lib/ringbuf.h"
+#include <string.h>
 /*---------------------------------------------------------------------------*/
 void
-ringbuf_init(struct ringbuf *r, uint8_t *dataptr, uint8_t size)
+ringbuf_init(struct ringbuf *r, uint8_t *dataptr, uint32_t size)
 {
   r->data = dataptr;
   r->mask = size - 1;
@@ -51,47 +52,142 @@ ringbuf_init(struct ringbuf *r, uint8_t *dataptr, uint8_t size)
 int
 ringbuf_put(struct ringbuf *r, uint8_t c)
 {
+  ringbuf_index_t put_ptr;
+
   /* Check if buffer is full. If it is full, return 0 to indicate that
      the element was not inserted into the buffer.
 
      XXX: there is a potential risk for a race condition here, because
      the ->get_ptr field may be written concurrently by the
      ringbuf_get() function. To avoid this, access to ->get_ptr must
-     be atomic. We use an uint8_t type, which makes access atomic on
-     most platforms, but C does not guarantee this.
+     be atomic. We use ringbuf_index_t, which should be chosen so that
+     access is atomic on the platform, but C does not guarantee this.
   */
-  if(((r->put_ptr - r->get_ptr) & r->mask) == r->mask) {
+  put_ptr = r->put_ptr;
+  if(((put_ptr - r->get_ptr) & r->mask) == r->mask) {
     return 0;
   }
-  r->data[r->put_ptr] = c;
-  r->put_ptr = (r->put_ptr + 1) & r->mask;
+  r->data[put_ptr] = c;
+
+  /* The byte must be in the buffer before the consumer can see it. */
+  RINGBUF_BARRIER();
+  r->put_ptr = (put_ptr + 1) & r->mask;
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 int
 ringbuf_get(struct ringbuf *r)
 {
+  ringbuf_index_t get_ptr;
   uint8_t c;
-  
+
   /* Check if there are bytes in the buffer. If so, we return the
      first one and increase the pointer. If there are no bytes left, we
      return -1.
 
      XXX: there is a potential risk for a race condition here, because
      the ->put_ptr field may be written concurrently by the
-     ringbuf_put() function. To avoid this, access to ->get_ptr must
-     be atomic. We use an uint8_t type, which makes access atomic on
-     most platforms, but C does not guarantee this.
+     ringbuf_put() function. To avoid this, access to ->put_ptr must
+     be atomic. We use ringbuf_index_t, which should be chosen so that
+     access is atomic on the platform, but C does not guarantee this.
   */
-  if(((r->put_ptr - r->get_ptr) & r->mask) > 0) {
-    c = r->data[r->get_ptr];
-    r->get_ptr = (r->get_ptr + 1) & r->mask;
+  get_ptr = r->get_ptr;
+  if(((r->put_ptr - get_ptr) & r->mask) > 0) {
+    /* Read the byte only after the write position has been read. */
+    RINGBUF_BARRIER();
+    c = r->data[get_ptr];
+
+    /* The byte must be read before the producer may overwrite it. */
+    RINGBUF_BARRIER();
+    r->get_ptr = (get_ptr + 1) & r->mask;
     return c;
   } else {
     return -1;
   }
 }
 /*---------------------------------------------------------------------------*/
+unsigned int
+ringbuf_put_bulk(struct ringbuf *r, const uint8_t *data, unsigned int len)
+{
+  ringbuf_index_t put_ptr;
+  unsigned int space, chunk;
+
+  put_ptr = r->put_ptr;
+  space = (r->get_ptr - put_ptr - 1) & r->mask;
+  if(len > space) {
+    len = space;
+  }
+  if(len == 0) {
+    return 0;
+  }
+
+  /* Copy up to the end of the array, then wrap around to the start. */
+  chunk = (unsigned int)r->mask + 1 - put_ptr;
+  if(chunk > len) {
+    chunk = len;
+  }
+  memcpy(&r->data[put_ptr], data, chunk);
+  if(len > chunk) {
+    memcpy(r->data, data + chunk, len - chunk);
+  }
+
+  RINGBUF_BARRIER();
+  r->put_ptr = (put_ptr + len) & r->mask;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+unsigned int
+ringbuf_get_bulk(struct ringbuf *r, uint8_t *data, unsigned int len)
+{
+  uint8_t *span;
+  unsigned int n, total;
+
+  total = 0;
+  while(total < len) {
+    n = ringbuf_peek(r, &span);
+    if(n == 0) {
+      break;
+    }
+    if(n > len - total) {
+      n = len - total;
+    }
+    if(data != NULL) {
+      memcpy(data + total, span, n);
+    }
+    ringbuf_consume(r, n);
+    total += n;
+  }
+  return total;
+}
+/*---------------------------------------------------------------------------*/
+unsigned int
+ringbuf_peek(struct ringbuf *r, uint8_t **span)
+{
+  ringbuf_index_t get_ptr;
+  unsigned int n, chunk;
+
+  get_ptr = r->get_ptr;
+  n = (r->put_ptr - get_ptr) & r->mask;
+
+  /* The data must not be read before the write position. */
+  RINGBUF_BARRIER();
+
+  chunk = (unsigned int)r->mask + 1 - get_ptr;
+  if(n > chunk) {
+    n = chunk;
+  }
+  *span = &r->data[get_ptr];
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void
+ringbuf_consume(struct ringbuf *r, unsigned int len)
+{
+  /* The span must have been read before the producer may reuse it. */
+  RINGBUF_BARRIER();
+  r->get_ptr = (r->get_ptr + len) & r->mask;
+}
+/*---------------------------------------------------------------------------*/
 int
 ringbuf_size(struct ringbuf *r)
 {
@@ -56,6 +56,48 @@
 
 #include "contiki-conf.h"
 
+/**
+ * \brief      Type of the ring buffer read and write positions
+ *
+ *             A ring buffer can hold at most 2^(8 * sizeof(ringbuf_index_t))
+ *             bytes. The default is uint8_t, giving buffers of up to
+ *             256 bytes whose positions can be read and written
+ *             atomically on 8-bit microcontrollers. Platforms that
+ *             can update a 16-bit quantity atomically can set
+ *             RINGBUF_CONF_INDEX_TYPE to uint16_t for buffers of up
+ *             to 64 KiB.
+ */
+#ifdef RINGBUF_CONF_INDEX_TYPE
+typedef RINGBUF_CONF_INDEX_TYPE ringbuf_index_t;
+#else /* RINGBUF_CONF_INDEX_TYPE */
+typedef uint8_t ringbuf_index_t;
+#endif /* RINGBUF_CONF_INDEX_TYPE */
+
+/**
+ * \brief      Memory barrier between the producer and the consumer
+ *
+ *             The ring buffer is safe for one producer and one
+ *             consumer running concurrently, for example an interrupt
+ *             handler and a process. The producer writes the data
+ *             before it publishes the new write position, and the
+ *             consumer reads the data before it publishes the new
+ *             read position. This barrier keeps the compiler (and, if
+ *             configured, the CPU) from reordering those accesses.
+ *
+ *             The default is a compiler barrier, which is enough on
+ *             single-core microcontrollers. Platforms where the
+ *             producer and consumer may run on different CPU cores,
+ *             such as threads on the native platform, should set
+ *             RINGBUF_CONF_BARRIER() to a full memory barrier.
+ */
+#ifdef RINGBUF_CONF_BARRIER
+#define RINGBUF_BARRIER() RINGBUF_CONF_BARRIER()
+#elif defined(__GNUC__)
+#define RINGBUF_BARRIER() __asm__ __volatile__("" : : : "memory")
+#else
+#define RINGBUF_BARRIER()
+#endif
+
 /**
  * \brief      Structure that holds the state of a ring buffer.
  *
@@ -67,10 +109,12 @@
  */
 struct ringbuf {
   uint8_t *data;
-  uint8_t mask;
+  ringbuf_index_t mask;
 
-  /* XXX these must be 8-bit quantities to avoid race conditions. */
-  uint8_t put_ptr, get_ptr;
+  /* XXX these must be quantities that the platform reads and writes
+     atomically to avoid race conditions. put_ptr is only written by
+     the producer and get_ptr only by the consumer. */
+  volatile ringbuf_index_t put_ptr, get_ptr;
 };
 
 /**
@@ -82,12 +126,14 @@ struct ringbuf {
  *             This function initiates a ring buffer. The data in the
  *             buffer is stored in an external array, to which a
  *             pointer must be supplied. The size of the ring buffer
- *             must be a power of two and cannot be larger than 128
- *             bytes.
+ *             must be a power of two and cannot be larger than
+ *             2^(8 * sizeof(ringbuf_index_t)) bytes, i.e. 256 bytes
+ *             by default. One byte of the array is always kept
+ *             unused.
  *
  */
 void    ringbuf_init(struct ringbuf *r, uint8_t *a,
-		     uint8_t size_power_of_two);
+		     uint32_t size_power_of_two);
 
 /**
  * \brief      Insert a byte into the ring buffer
@@ -115,6 +161,64 @@ int     ringbuf_put(struct ringbuf *r, uint8_t c);
  */
 int     ringbuf_get(struct ringbuf *r);
 
+/**
+ * \brief      Insert several bytes into the ring buffer
+ * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
+ * \param data A pointer to the bytes to be written
+ * \param len  The number of bytes to be written
+ * \return     The number of bytes written, which is less than len if the buffer became full.
+ *
+ *             This function copies as many bytes as fit into the ring
+ *             buffer, with at most two memcpy() calls, and publishes
+ *             them to the consumer all at once. It must only be
+ *             called from the producer side.
+ *
+ */
+unsigned int ringbuf_put_bulk(struct ringbuf *r, const uint8_t *data,
+                              unsigned int len);
+
+/**
+ * \brief      Get several bytes from the ring buffer
+ * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
+ * \param data A pointer to where the bytes are copied, or NULL to discard them
+ * \param len  The maximum number of bytes to get
+ * \return     The number of bytes removed from the buffer.
+ *
+ *             This function must only be called from the consumer
+ *             side.
+ *
+ */
+unsigned int ringbuf_get_bulk(struct ringbuf *r, uint8_t *data,
+                              unsigned int len);
+
+/**
+ * \brief      Get the contiguous span of bytes at the head of the ring buffer
+ * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
+ * \param span A pointer to a pointer that is set to the first byte in the buffer
+ * \return     The number of bytes that can be read directly at *span.
+ *
+ *             This function gives the consumer direct access to the
+ *             buffered data without copying it. The span ends at the
+ *             end of the data or at the end of the array, whichever
+ *             comes first, so a second call may be needed after the
+ *             buffer has wrapped. The bytes stay in the buffer until
+ *             they are released with ringbuf_consume().
+ *
+ */
+unsigned int ringbuf_peek(struct ringbuf *r, uint8_t **span);
+
+/**
+ * \brief      Remove bytes from the head of the ring buffer
+ * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
+ * \param len  The number of bytes to remove
+ *
+ *             This function releases bytes previously obtained with
+ *             ringbuf_peek(). len must not be larger than the number
+ *             of elements in the buffer.
+ *
+ */
+void    ringbuf_consume(struct ringbuf *r, unsigned int len);
+
 /**
  * \brief      Get the size of a ring buffer
  * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
@@ -41,6 +41,9 @@
 #include "contiki-net.h"
 #include "net/ip/uip-split.h"
 #include "net/ip/uip-packetqueue.h"
+#include "net/packetbuf.h"
+#include "lib/list.h"
+#include "lib/memb.h"
 
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip-nd6.h"
@@ -106,6 +109,31 @@ enum {
   PACKET_INPUT
 };
 
+#if TCPIP_QUEUE_BUFFERS
+/* A packet waiting on the input or output queue, with the packetbuf
+   attributes it was received with. */
+struct queued_packet {
+  struct queued_packet *next;
+  uint16_t len;
+  uint8_t ext_len;
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+  uint8_t data[UIP_BUFSIZE];
+};
+
+MEMB(queued_packet_memb, struct queued_packet, TCPIP_QUEUE_BUFFERS);
+LIST(input_queue);
+#if NETSTACK_CONF_WITH_IPV6
+LIST(output_queue);
+/* Set while a packet from the output queue is being sent, so that
+   tcpip_ipv6_output() sends the packets it is called with at once. */
+static uint8_t sending_queued;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+static unsigned short queue_used;
+
+struct tcpip_queue_stats tcpip_queue_stats;
+#endif /* TCPIP_QUEUE_BUFFERS */
+
 /* Called on IP packet output. */
 #if NETSTACK_CONF_WITH_IPV6
 
@@ -225,6 +253,76 @@ packet_input(void)
 #endif /* UIP_CONF_IP_FORWARD */
 }
 /*---------------------------------------------------------------------------*/
+#if TCPIP_QUEUE_BUFFERS
+static struct queued_packet *
+queue_packet(list_t queue)
+{
+  struct queued_packet *q;
+
+  q = memb_alloc(&queued_packet_memb);
+  if(q != NULL) {
+    q->len = uip_len;
+#if NETSTACK_CONF_WITH_IPV6
+    q->ext_len = uip_ext_len;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+    memcpy(q->data, uip_buf, uip_len);
+    list_add(queue, q);
+    if(++queue_used > tcpip_queue_stats.max_used) {
+      tcpip_queue_stats.max_used = queue_used;
+    }
+    process_poll(&tcpip_process);
+  }
+  return q;
+}
+/*---------------------------------------------------------------------------*/
+static void
+unqueue_packet(struct queued_packet *q)
+{
+  uip_len = q->len;
+#if NETSTACK_CONF_WITH_IPV6
+  uip_ext_len = q->ext_len;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  memcpy(uip_buf, q->data, q->len);
+  memb_free(&queued_packet_memb, q);
+  queue_used--;
+}
+/*---------------------------------------------------------------------------*/
+#if NETSTACK_CONF_WITH_IPV6
+static void ipv6_output(void);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+static void
+process_queues(void)
+{
+  struct queued_packet *q;
+
+  /* The output queue is emptied before each incoming packet is
+     processed, so that the replies to a burst of packets do not pile
+     up behind it. */
+  while(1) {
+#if NETSTACK_CONF_WITH_IPV6
+    while((q = list_pop(output_queue)) != NULL) {
+      unqueue_packet(q);
+      sending_queued = 1;
+      ipv6_output();
+      sending_queued = 0;
+    }
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+    q = list_pop(input_queue);
+    if(q == NULL) {
+      break;
+    }
+    packetbuf_attr_copyfrom(q->attrs, q->addrs);
+    unqueue_packet(q);
+    packet_input();
+  }
+  uip_len = 0;
+#if NETSTACK_CONF_WITH_IPV6
+  uip_ext_len = 0;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+}
+#endif /* TCPIP_QUEUE_BUFFERS */
+/*---------------------------------------------------------------------------*/
 #if UIP_TCP
 #if UIP_ACTIVE_OPEN
 struct uip_conn *
@@ -371,7 +469,11 @@ static void
 eventhandler(process_event_t ev, process_data_t data)
 {
 #if UIP_TCP
+#if UIP_CONNS > 255
+  static unsigned short i;
+#else /* UIP_CONNS > 255 */
   static unsigned char i;
+#endif /* UIP_CONNS > 255 */
   register struct listenport *l;
 #endif /*UIP_TCP*/
   struct process *p;
@@ -413,7 +515,7 @@ eventhandler(process_event_t ev, process_data_t data)
         for(cptr = &uip_udp_conns[0];
             cptr < &uip_udp_conns[UIP_UDP_CONNS]; ++cptr) {
           if(cptr->appstate.p == p) {
-            cptr->lport = 0;
+            uip_udp_remove(cptr);
           }
         }
       }
@@ -522,22 +624,76 @@ eventhandler(process_event_t ev, process_data_t data)
     case PACKET_INPUT:
       packet_input();
       break;
+#if TCPIP_QUEUE_BUFFERS
+    case PROCESS_EVENT_POLL:
+      process_queues();
+      break;
+#endif /* TCPIP_QUEUE_BUFFERS */
   };
 }
 /*---------------------------------------------------------------------------*/
 void
 tcpip_input(void)
 {
+#if TCPIP_QUEUE_BUFFERS
+  struct queued_packet *q;
+
+  q = queue_packet(input_queue);
+  if(q != NULL) {
+    packetbuf_attr_copyto(q->attrs, q->addrs);
+    tcpip_queue_stats.rx_queued++;
+  } else {
+    tcpip_queue_stats.rx_dropped++;
+  }
+#else /* TCPIP_QUEUE_BUFFERS */
   process_post_synch(&tcpip_process, PACKET_INPUT, NULL);
+#endif /* TCPIP_QUEUE_BUFFERS */
   uip_len = 0;
 #if NETSTACK_CONF_WITH_IPV6
   uip_ext_len = 0;
 #endif /*NETSTACK_CONF_WITH_IPV6*/
 }
 /*---------------------------------------------------------------------------*/
+#if NETSTACK_CONF_WITH_IPV6 && UIP_CONF_IPV6_QUEUE_PKT
+static void
+queue_for_nbr(uip_ds6_nbr_t *nbr)
+{
+  struct uip_packetqueue_packet *p;
+
+  p = uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
+  if(p != NULL) {
+    memcpy(p->queue_buf, UIP_IP_BUF, uip_len);
+    p->queue_buf_len = uip_len;
+  }
+}
+#endif /* NETSTACK_CONF_WITH_IPV6 && UIP_CONF_IPV6_QUEUE_PKT */
+/*---------------------------------------------------------------------------*/
 #if NETSTACK_CONF_WITH_IPV6
+#if TCPIP_QUEUE_BUFFERS
 void
 tcpip_ipv6_output(void)
+{
+  if(uip_len == 0) {
+    return;
+  }
+  if(!sending_queued) {
+    if(queue_packet(output_queue) != NULL) {
+      tcpip_queue_stats.tx_queued++;
+      uip_len = 0;
+      uip_ext_len = 0;
+      return;
+    }
+    tcpip_queue_stats.tx_unqueued++;
+  }
+  ipv6_output();
+}
+/*---------------------------------------------------------------------------*/
+static void
+ipv6_output(void)
+#else /* TCPIP_QUEUE_BUFFERS */
+void
+tcpip_ipv6_output(void)
+#endif /* TCPIP_QUEUE_BUFFERS */
 {
   uip_ds6_nbr_t *nbr = NULL;
   uip_ipaddr_t *nexthop;
@@ -656,10 +812,7 @@ tcpip_ipv6_output(void)
       } else {
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* Copy outgoing pkt in the queuing buffer for later transmit. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        queue_for_nbr(nbr);
 #endif
       /* RFC4861, 7.2.2:
        * "If the source address of the packet prompting the solicitation is the
@@ -684,10 +837,7 @@ tcpip_ipv6_output(void)
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* Copy outgoing pkt in the queuing buffer for later transmit and set
            the destination nbr to nbr. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        queue_for_nbr(nbr);
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
         uip_len = 0;
         return;
@@ -706,12 +856,13 @@ tcpip_ipv6_output(void)
 
 #if UIP_CONF_IPV6_QUEUE_PKT
       /*
-       * Send the queued packets from here, may not be 100% perfect though.
-       * This happens in a few cases, for example when instead of receiving a
-       * NA after sendiong a NS, you receive a NS with SLLAO: the entry moves
-       * to STALE, and you must both send a NA and the queued packet.
+       * Send the queued packets from here, oldest first, may not be 100%
+       * perfect though. This happens in a few cases, for example when
+       * instead of receiving a NA after sendiong a NS, you receive a NS
+       * with SLLAO: the entry moves to STALE, and you must both send a NA
+       * and the queued packets.
        */
-      if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
+      while(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
         uip_len = uip_packetqueue_buflen(&nbr->packethandle);
         memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
         uip_packetqueue_free(&nbr->packethandle);
@@ -813,6 +964,14 @@ PROCESS_THREAD(tcpip_process, ev, data)
 #endif /* UIP_CONF_ICMP6 */
   etimer_set(&periodic, CLOCK_SECOND / 2);
 
+#if TCPIP_QUEUE_BUFFERS
+  memb_init(&queued_packet_memb);
+  list_init(input_queue);
+#if NETSTACK_CONF_WITH_IPV6
+  list_init(output_queue);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+#endif /* TCPIP_QUEUE_BUFFERS */
+
   uip_init();
 #ifdef UIP_FALLBACK_INTERFACE
   UIP_FALLBACK_INTERFACE.init();
@@ -325,6 +325,48 @@ CCIF extern process_event_t tcpip_event;
  * @{
  */
 
+/**
+ * \brief Number of packet buffers for the input and output queues
+ *
+ * With a non-zero TCPIP_CONF_QUEUE_BUFFERS, tcpip_input() and
+ * tcpip_ipv6_output() do not process the packet in uip_buf
+ * themselves. They copy it to a buffer from a pool of this many
+ * packet buffers, put it on an input or output queue, and poll the
+ * tcpip process, which later processes the queued packets back to
+ * back. A driver can thus hand over a burst of packets without waiting
+ * for each one to be processed, and uip_buf is free again as soon as
+ * a packet has been queued. Incoming packets keep their packetbuf
+ * attributes while they are queued.
+ *
+ * When the pool is empty, an incoming packet is dropped, and an
+ * outgoing packet is sent at once as without the queues.
+ */
+#ifdef TCPIP_CONF_QUEUE_BUFFERS
+#define TCPIP_QUEUE_BUFFERS TCPIP_CONF_QUEUE_BUFFERS
+#else /* TCPIP_CONF_QUEUE_BUFFERS */
+#define TCPIP_QUEUE_BUFFERS 0
+#endif /* TCPIP_CONF_QUEUE_BUFFERS */
+
+#if TCPIP_QUEUE_BUFFERS
+/**
+ * Statistics of the input and output queues.
+ */
+struct tcpip_queue_stats {
+  /** The number of incoming packets queued. */
+  unsigned long rx_queued;
+  /** The number of incoming packets dropped because no buffer was free. */
+  unsigned long rx_dropped;
+  /** The number of outgoing packets queued. */
+  unsigned long tx_queued;
+  /** The number of outgoing packets sent at once because no buffer
+      was free. */
+  unsigned long tx_unqueued;
+  /** The highest number of buffers in use at the same time. */
+  unsigned short max_used;
+};
+extern struct tcpip_queue_stats tcpip_queue_stats;
+#endif /* TCPIP_QUEUE_BUFFERS */
+
 /**
  * \brief      Deliver an incoming packet to the TCP/IP stack
  *
@@ -332,7 +374,9 @@ CCIF extern process_event_t tcpip_event;
  *             deliver an incoming packet to the TCP/IP stack. The
  *             incoming packet must be present in the uip_buf buffer,
  *             and the length of the packet must be in the global
- *             uip_len variable.
+ *             uip_len variable. With TCPIP_CONF_QUEUE_BUFFERS, the
+ *             packet is queued and processed later by the tcpip
+ *             process.
  */
 CCIF void tcpip_input(void);
 
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup uipchksum
+ * @{
+ */
+
+/**
+ * \file
+ *         The Internet checksum
+ */
+
+#include "net/ip/uip-chksum.h"
+#include "net/ip/uip.h"
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+add16(uint16_t sum, uint16_t t)
+{
+  sum += t;
+  if(sum < t) {
+    sum++;      /* carry */
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_CHKSUM_WIDE
+uint16_t
+uip_chksum_add(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  uint64_t acc;
+  uint32_t w32;
+  uint16_t w16;
+
+  /* The words are summed in host byte order, which gives the
+     byte-swapped sum on little-endian hosts (RFC 1071, section 2B).
+     The packet length keeps the accumulator from overflowing. */
+  acc = 0;
+
+  while(len >= 16) {
+    memcpy(&w32, data, 4);
+    acc += w32;
+    memcpy(&w32, data + 4, 4);
+    acc += w32;
+    memcpy(&w32, data + 8, 4);
+    acc += w32;
+    memcpy(&w32, data + 12, 4);
+    acc += w32;
+    data += 16;
+    len -= 16;
+  }
+  while(len >= 4) {
+    memcpy(&w32, data, 4);
+    acc += w32;
+    data += 4;
+    len -= 4;
+  }
+  if(len >= 2) {
+    memcpy(&w16, data, 2);
+    acc += w16;
+    data += 2;
+    len -= 2;
+  }
+  if(len == 1) {
+    /* The last byte is the first byte of a zero-padded word */
+    w16 = 0;
+    memcpy(&w16, data, 1);
+    acc += w16;
+  }
+
+  while(acc >> 16) {
+    acc = (acc & 0xffff) + (acc >> 16);
+  }
+
+  /* Return sum in host byte order. */
+  return add16(sum, uip_htons((uint16_t)acc));
+}
+#else /* UIP_CHKSUM_WIDE */
+uint16_t
+uip_chksum_add(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  const uint8_t *dataptr;
+  const uint8_t *last_byte;
+
+  dataptr = data;
+  last_byte = data + len - 1;
+
+  while(dataptr < last_byte) {   /* At least two more bytes */
+    sum = add16(sum, (dataptr[0] << 8) + dataptr[1]);
+    dataptr += 2;
+  }
+
+  if(dataptr == last_byte) {
+    sum = add16(sum, dataptr[0] << 8);
+  }
+
+  /* Return sum in host byte order. */
+  return sum;
+}
+#endif /* UIP_CHKSUM_WIDE */
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_adjust(uint16_t chksum, uint16_t old_sum, uint16_t new_sum)
+{
+  uint16_t sum;
+
+  /* HC' = ~(~HC + ~m + m') */
+  sum = add16(~chksum, ~old_sum);
+  sum = add16(sum, new_sum);
+  return ~sum;
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
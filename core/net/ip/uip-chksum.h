@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+/**
+ * \defgroup uipchksum uIP Internet checksum
+ * @{
+ *
+ * The Internet checksum (RFC 1071) shared by IPv4, IPv6 and ip64,
+ * and incremental checksum updates (RFC 1624) for code that rewrites
+ * parts of a packet, such as addresses or port numbers.
+ *
+ * By default, the checksum is summed two bytes at a time, which suits
+ * 8-bit and 16-bit CPUs. With UIP_CONF_CHKSUM_WIDE, it is summed a
+ * 32-bit word at a time into a 64-bit accumulator, which is several
+ * times faster on 32-bit and 64-bit CPUs.
+ */
+
+/**
+ * \file
+ *         Header file for the Internet checksum
+ */
+
+#ifndef UIP_CHKSUM_H_
+#define UIP_CHKSUM_H_
+
+#include "contiki-conf.h"
+
+#ifdef UIP_CONF_CHKSUM_WIDE
+#define UIP_CHKSUM_WIDE UIP_CONF_CHKSUM_WIDE
+#else /* UIP_CONF_CHKSUM_WIDE */
+#define UIP_CHKSUM_WIDE 0
+#endif /* UIP_CONF_CHKSUM_WIDE */
+
+/**
+ * \brief      Add data to a ones' complement sum
+ * \param sum  The sum so far, in host byte order
+ * \param data The data, in network byte order
+ * \param len  The length of the data
+ * \return     The new sum, in host byte order
+ *
+ *             The checksum of a packet is the ones' complement of the
+ *             sum of all its parts. A part with an odd length must
+ *             be the last one.
+ */
+uint16_t uip_chksum_add(uint16_t sum, const uint8_t *data, uint16_t len);
+
+/**
+ * \brief         Update a checksum after a part of the packet changed
+ * \param chksum  The checksum field of the packet, in host byte order
+ * \param old_sum The sum of the old contents of the changed part
+ * \param new_sum The sum of the new contents of the changed part
+ * \return        The new checksum field, in host byte order
+ *
+ *                This implements equation 3 of RFC 1624. The changed
+ *                part must start at an even offset from the start of
+ *                the checksummed data, and its sums are computed with
+ *                uip_chksum_add(). This avoids summing the rest of the
+ *                packet again.
+ */
+uint16_t uip_chksum_adjust(uint16_t chksum, uint16_t old_sum, uint16_t new_sum);
+
+#endif /* UIP_CHKSUM_H_ */
+
+/** @} */
+/** @} */
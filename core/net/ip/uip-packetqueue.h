@@ -3,30 +3,78 @@
 
 #include "sys/ctimer.h"
 
+/* The number of packet buffers shared by all queues. */
+#ifdef UIP_PACKETQUEUE_CONF_NUM
+#define UIP_PACKETQUEUE_NUM UIP_PACKETQUEUE_CONF_NUM
+#else /* UIP_PACKETQUEUE_CONF_NUM */
+#define UIP_PACKETQUEUE_NUM 2
+#endif /* UIP_PACKETQUEUE_CONF_NUM */
+
+/* The number of packets that can wait on one queue handle, that is,
+   for one neighbor while its link-layer address is being resolved.
+   Further packets are dropped until the queue is emptied. */
+#ifdef UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#else /* UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE */
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE 1
+#endif /* UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE */
+
 struct uip_packetqueue_handle;
 
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
+  struct uip_packetqueue_packet *next;
   uint8_t queue_buf[UIP_BUFSIZE - UIP_LLH_LEN];
   uint16_t queue_buf_len;
   struct ctimer lifetimer;
   struct uip_packetqueue_handle *handle;
 };
 
+/* A queue of packets, oldest first. */
 struct uip_packetqueue_handle {
   struct uip_packetqueue_packet *packet;
+  uint8_t count;
 };
 
-void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
+/* Packet counts of all queues. */
+/* Count queued and dropped packets in uip_packetqueue_stats */
+#ifdef UIP_PACKETQUEUE_CONF_STATS
+#define UIP_PACKETQUEUE_STATS UIP_PACKETQUEUE_CONF_STATS
+#else /* UIP_PACKETQUEUE_CONF_STATS */
+#define UIP_PACKETQUEUE_STATS 0
+#endif /* UIP_PACKETQUEUE_CONF_STATS */
 
+#if UIP_PACKETQUEUE_STATS
+struct uip_packetqueue_stats {
+  /* Packets put on a queue. */
+  unsigned long queued;
+  /* Packets dropped because all packet buffers were in use. */
+  unsigned long dropped_full;
+  /* Packets dropped because their queue already held
+     UIP_PACKETQUEUE_MAX_PER_HANDLE packets. */
+  unsigned long dropped_limit;
+  /* Packets dropped because their lifetime ended while queued. */
+  unsigned long expired;
+};
+extern struct uip_packetqueue_stats uip_packetqueue_stats;
+#endif /* UIP_PACKETQUEUE_STATS */
 
+void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
+
+/* Add a packet buffer to the end of the queue. Returns NULL if the
+   queue is full or no buffer is free. The packet is dropped when its
+   lifetime ends. */
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
 
-
+/* Remove the oldest packet from the queue. */
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
+/* Remove all packets from the queue. */
+void
+uip_packetqueue_clear(struct uip_packetqueue_handle *handle);
+
+/* The oldest packet on the queue. */
 uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
 uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
 void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
@@ -873,7 +873,11 @@ struct uip_udp_conn *uip_udp_new(const uip_ipaddr_t *ripaddr, uint16_t rport);
  *
  * \hideinitializer
  */
+#if UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6
+#define uip_udp_remove(conn) ((conn)->lport = 0, uip_udp_rehash(conn))
+#else /* UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6 */
 #define uip_udp_remove(conn) (conn)->lport = 0
+#endif /* UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6 */
 
 /**
  * Bind a UDP connection to a local port.
@@ -885,7 +889,20 @@ struct uip_udp_conn *uip_udp_new(const uip_ipaddr_t *ripaddr, uint16_t rport);
  *
  * \hideinitializer
  */
+#if UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6
+#define uip_udp_bind(conn, port) ((conn)->lport = (port), uip_udp_rehash(conn))
+#else /* UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6 */
 #define uip_udp_bind(conn, port) (conn)->lport = port
+#endif /* UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6 */
+
+#if UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6
+/**
+ * Update the demultiplexing hash table after the local port of a UDP
+ * connection has changed. Called by uip_udp_bind() and
+ * uip_udp_remove().
+ */
+void uip_udp_rehash(struct uip_udp_conn *conn);
+#endif /* UIP_DEMUX_HASH_SIZE && NETSTACK_CONF_WITH_IPV6 */
 
 /**
  * Send a UDP datagram of length len on the current connection.
@@ -435,6 +435,26 @@ void uip_log(char *msg);
 #define UIP_LISTENPORTS (UIP_CONF_MAX_LISTENPORTS)
 #endif /* UIP_CONF_MAX_LISTENPORTS */
 
+/**
+ * The size of the hash tables used to demultiplex incoming UDP and
+ * TCP packets.
+ *
+ * When non-zero, the IPv6 stack finds the connection for an incoming
+ * packet through a hash table keyed by the local port (UDP), or by
+ * the ports and the remote address (TCP), instead of comparing the
+ * packet with every connection. This pays off when UIP_UDP_CONNS or
+ * UIP_CONNS is large. Must be a power of two. With the hash tables,
+ * the local port of a UDP connection must only be changed with
+ * uip_udp_bind() and uip_udp_remove().
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_DEMUX_HASH_SIZE
+#define UIP_DEMUX_HASH_SIZE (UIP_CONF_DEMUX_HASH_SIZE)
+#else /* UIP_CONF_DEMUX_HASH_SIZE */
+#define UIP_DEMUX_HASH_SIZE 0
+#endif /* UIP_CONF_DEMUX_HASH_SIZE */
+
 /**
  * Determines if support for TCP urgent data notification should be
  * compiled in.
@@ -570,6 +590,19 @@ void uip_log(char *msg);
 #define SICSLOWPAN_REASS_MAXAGE 20
 #endif
 
+/**
+ * Number of datagrams that can be reassembled at the same time at the
+ * 6lowpan layer. Each needs a buffer of UIP_BUFSIZE bytes. Fragments
+ * of a datagram are matched by sender, tag and size, and may arrive in
+ * any order. When all contexts are busy, the oldest datagram is dropped
+ * to make room for a new one.
+ */
+#ifdef SICSLOWPAN_CONF_REASS_CONTEXTS
+#define SICSLOWPAN_REASS_CONTEXTS (SICSLOWPAN_CONF_REASS_CONTEXTS)
+#else
+#define SICSLOWPAN_REASS_CONTEXTS 1
+#endif
+
 /**
  * Do we compress the IP header or not (default: no)
  */
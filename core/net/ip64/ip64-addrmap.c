@@ -39,20 +39,77 @@
 
 #include <string.h>
 
+#define DEBUG 0
+
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else /* DEBUG */
+#define PRINTF(...)
+#endif /* DEBUG */
+
 #ifdef IP64_ADDRMAP_CONF_ENTRIES
 #define NUM_ENTRIES IP64_ADDRMAP_CONF_ENTRIES
 #else /* IP64_ADDRMAP_CONF_ENTRIES */
 #define NUM_ENTRIES 32
 #endif /* IP64_ADDRMAP_CONF_ENTRIES */
 
+/* The mappings are found through two hash tables of chains: one keyed
+   by the addresses, ports and protocol of the flow, for packets from
+   the IPv6 side, and one keyed by the mapped port, for packets from
+   the IPv4 side. Must be a power of two. */
+#ifdef IP64_ADDRMAP_CONF_HASH_SIZE
+#define HASH_SIZE IP64_ADDRMAP_CONF_HASH_SIZE
+#else /* IP64_ADDRMAP_CONF_HASH_SIZE */
+#define HASH_SIZE 32
+#endif /* IP64_ADDRMAP_CONF_HASH_SIZE */
+
+/* Mappings are aged with a timer wheel of WHEEL_SLOTS slots of
+   WHEEL_TICK clock ticks each. A mapping is kept in the slot that is
+   due when its lifetime ends; a mapping that lives longer than the
+   span of the wheel is put in the last slot and moved on when that
+   slot is due. WHEEL_SLOTS must be a power of two, no larger than
+   256. */
+#ifdef IP64_ADDRMAP_CONF_WHEEL_SLOTS
+#define WHEEL_SLOTS IP64_ADDRMAP_CONF_WHEEL_SLOTS
+#else /* IP64_ADDRMAP_CONF_WHEEL_SLOTS */
+#define WHEEL_SLOTS 16
+#endif /* IP64_ADDRMAP_CONF_WHEEL_SLOTS */
+
+#ifdef IP64_ADDRMAP_CONF_WHEEL_TICK
+#define WHEEL_TICK IP64_ADDRMAP_CONF_WHEEL_TICK
+#else /* IP64_ADDRMAP_CONF_WHEEL_TICK */
+#define WHEEL_TICK (CLOCK_SECOND * 2)
+#endif /* IP64_ADDRMAP_CONF_WHEEL_TICK */
+
+#if (HASH_SIZE & (HASH_SIZE - 1)) != 0
+#error "IP64_ADDRMAP_CONF_HASH_SIZE must be a power of two"
+#endif
+#if (WHEEL_SLOTS & (WHEEL_SLOTS - 1)) != 0 || WHEEL_SLOTS > 256
+#error "IP64_ADDRMAP_CONF_WHEEL_SLOTS must be a power of two no larger than 256"
+#endif
+
 MEMB(entrymemb, struct ip64_addrmap_entry, NUM_ENTRIES);
 LIST(entrylist);
 
+static struct ip64_addrmap_entry *flow_hash[HASH_SIZE];
+static struct ip64_addrmap_entry *port_hash[HASH_SIZE];
+
+static struct ip64_addrmap_entry *wheel[WHEEL_SLOTS];
+/* The slot that is due next, and the time when it is due. */
+static uint8_t wheel_pos;
+static clock_time_t wheel_time;
+
 #define FIRST_MAPPED_PORT 10000
 #define LAST_MAPPED_PORT  20000
 static uint16_t mapped_port = FIRST_MAPPED_PORT;
 
-#define printf(...)
+#if IP64_ADDRMAP_STATS
+struct ip64_addrmap_stats ip64_addrmap_stats;
+#define STATS_ADD(field, n) ip64_addrmap_stats.field += (n)
+#else /* IP64_ADDRMAP_STATS */
+#define STATS_ADD(field, n)
+#endif /* IP64_ADDRMAP_STATS */
 
 /*---------------------------------------------------------------------------*/
 struct ip64_addrmap_entry *
@@ -66,24 +123,175 @@ ip64_addrmap_init(void)
 {
   memb_init(&entrymemb);
   list_init(entrylist);
+  memset(flow_hash, 0, sizeof(flow_hash));
+  memset(port_hash, 0, sizeof(port_hash));
+  memset(wheel, 0, sizeof(wheel));
+  wheel_pos = 0;
+  wheel_time = clock_time() + WHEEL_TICK;
   mapped_port = FIRST_MAPPED_PORT;
+#if IP64_ADDRMAP_STATS
+  memset(&ip64_addrmap_stats, 0, sizeof(ip64_addrmap_stats));
+#endif /* IP64_ADDRMAP_STATS */
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+flow_hash_index(const uip_ip6addr_t *ip6addr,
+                uint16_t ip6port,
+                const uip_ip4addr_t *ip4addr,
+                uint16_t ip4port,
+                uint8_t protocol)
+{
+  unsigned h;
+  int i;
+
+  h = protocol ^ ip6port ^ (ip4port << 3);
+  for(i = 0; i < 8; i++) {
+    h = (h * 33) ^ ip6addr->u16[i];
+  }
+  h = (h * 33) ^ ip4addr->u16[0];
+  h = (h * 33) ^ ip4addr->u16[1];
+  return (h ^ (h >> 8) ^ (h >> 16)) & (HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+port_hash_index(uint16_t port)
+{
+  /* Mapped ports are picked at random, so their low bits spread well
+     enough. The protocol is left out so that the chain also tells if
+     a port is in use by any protocol. */
+  return (port ^ (port >> 8)) & (HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+wheel_slot(struct ip64_addrmap_entry *m)
+{
+  clock_time_t remaining, ahead;
+  unsigned long k;
+
+  if(timer_expired(&m->timer)) {
+    return wheel_pos;
+  }
+  remaining = timer_remaining(&m->timer);
+  ahead = wheel_time - clock_time();
+  if((clock_time_t)(ahead - 1) < WHEEL_TICK) {
+    /* The next slot is due within one tick. */
+    if(remaining <= ahead) {
+      return wheel_pos;
+    }
+    k = (remaining - ahead + WHEEL_TICK - 1) / WHEEL_TICK;
+  } else {
+    /* The wheel is behind, which only happens while it is advanced. */
+    k = ((unsigned long)remaining + (clock_time_t)-ahead +
+         WHEEL_TICK - 1) / WHEEL_TICK;
+  }
+  if(k >= WHEEL_SLOTS) {
+    k = WHEEL_SLOTS - 1;
+  }
+  return (wheel_pos + k) & (WHEEL_SLOTS - 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_add(struct ip64_addrmap_entry *m)
+{
+  m->wheel_slot = wheel_slot(m);
+  m->wheel_next = wheel[m->wheel_slot];
+  wheel[m->wheel_slot] = m;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove(struct ip64_addrmap_entry *m)
+{
+  struct ip64_addrmap_entry **p;
+
+  for(p = &wheel[m->wheel_slot]; *p != NULL; p = &(*p)->wheel_next) {
+    if(*p == m) {
+      *p = m->wheel_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_entry(struct ip64_addrmap_entry *m)
+{
+  unsigned h;
+
+  h = flow_hash_index(&m->ip6addr, m->ip6port, &m->ip4addr, m->ip4port,
+                      m->protocol);
+  m->flow_next = flow_hash[h];
+  flow_hash[h] = m;
+  h = port_hash_index(m->mapped_port);
+  m->port_next = port_hash[h];
+  port_hash[h] = m;
+  wheel_add(m);
+  list_add(entrylist, m);
+
+#if IP64_ADDRMAP_STATS
+  ip64_addrmap_stats.created++;
+  if(++ip64_addrmap_stats.flows > ip64_addrmap_stats.max_flows) {
+    ip64_addrmap_stats.max_flows = ip64_addrmap_stats.flows;
+  }
+#endif /* IP64_ADDRMAP_STATS */
+}
+/*---------------------------------------------------------------------------*/
+/* Remove a mapping from the hash tables and free it. The caller has
+   already taken it off the timer wheel. */
+static void
+free_entry(struct ip64_addrmap_entry *m)
+{
+  struct ip64_addrmap_entry **p;
+
+  p = &flow_hash[flow_hash_index(&m->ip6addr, m->ip6port, &m->ip4addr,
+                                 m->ip4port, m->protocol)];
+  while(*p != m) {
+    p = &(*p)->flow_next;
+  }
+  *p = m->flow_next;
+
+  p = &port_hash[port_hash_index(m->mapped_port)];
+  while(*p != m) {
+    p = &(*p)->port_next;
+  }
+  *p = m->port_next;
+
+  list_remove(entrylist, m);
+  memb_free(&entrymemb, m);
+  STATS_ADD(flows, -1);
 }
 /*---------------------------------------------------------------------------*/
 static void
 check_age(void)
 {
-  struct ip64_addrmap_entry *m;
+  struct ip64_addrmap_entry *m, *next;
+  clock_time_t now;
+  int n;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-  m = list_head(entrylist);
-  while(m != NULL) {
-    if(timer_expired(&m->timer)) {
-      list_remove(entrylist, m);
-      memb_free(&entrymemb, m);
-      m = list_head(entrylist);
-    } else {
-      m = list_item_next(m);
+  /* Visit the slots that have become due since the last call. The
+     mappings in them have either expired and are thrown away, or got
+     a longer lifetime since they were put in the slot and are moved
+     to a later slot. After a long idle time, every slot is visited
+     once. */
+  now = clock_time();
+  for(n = 0;
+      (clock_time_t)(wheel_time - now - 1) >= WHEEL_TICK;
+      n++) {
+    if(n == WHEEL_SLOTS) {
+      wheel_time = now + WHEEL_TICK;
+      break;
+    }
+    m = wheel[wheel_pos];
+    wheel[wheel_pos] = NULL;
+    wheel_pos = (wheel_pos + 1) & (WHEEL_SLOTS - 1);
+    wheel_time += WHEEL_TICK;
+    for(; m != NULL; m = next) {
+      next = m->wheel_next;
+      if(timer_expired(&m->timer)) {
+        PRINTF("ip64-addrmap: mapped port %u expired\n", m->mapped_port);
+        free_entry(m);
+        STATS_ADD(expired, 1);
+      } else {
+        wheel_add(m);
+      }
     }
   }
 }
@@ -91,16 +299,22 @@ check_age(void)
 static int
 recycle(void)
 {
-  /* Find the oldest recyclable mapping and remove it. */
+  /* Find an expired mapping that the timer wheel has not come to yet,
+     or else the oldest recyclable mapping, and remove it. This only
+     happens when the table is full, so a walk through the whole list
+     is fine here. */
   struct ip64_addrmap_entry *m, *oldest;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-
   oldest = NULL;
   for(m = list_head(entrylist);
       m != NULL;
       m = list_item_next(m)) {
+    if(timer_expired(&m->timer)) {
+      wheel_remove(m);
+      free_entry(m);
+      STATS_ADD(expired, 1);
+      return 1;
+    }
     if(m->flags & FLAGS_RECYCLABLE) {
       if(oldest == NULL) {
         oldest = m;
@@ -116,14 +330,30 @@ recycle(void)
   /* If we found an oldest recyclable entry, remove it and return
      non-zero. */
   if(oldest != NULL) {
-    list_remove(entrylist, oldest);
-    memb_free(&entrymemb, oldest);
+    PRINTF("ip64-addrmap: recycling mapped port %u\n", oldest->mapped_port);
+    wheel_remove(oldest);
+    free_entry(oldest);
+    STATS_ADD(recycled, 1);
     return 1;
   }
 
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+/* A mapping whose lifetime ended within the current tick of the timer
+   wheel is still in the tables, but is not to be used any more. */
+static struct ip64_addrmap_entry *
+live_entry(struct ip64_addrmap_entry *m)
+{
+  if(timer_expired(&m->timer)) {
+    wheel_remove(m);
+    free_entry(m);
+    STATS_ADD(expired, 1);
+    return NULL;
+  }
+  return m;
+}
+/*---------------------------------------------------------------------------*/
 struct ip64_addrmap_entry *
 ip64_addrmap_lookup(const uip_ip6addr_t *ip6addr,
 		    uint16_t ip6port,
@@ -133,22 +363,17 @@ ip64_addrmap_lookup(const uip_ip6addr_t *ip6addr,
 {
   struct ip64_addrmap_entry *m;
 
-  printf("lookup ip4port %d ip6port %d\n", uip_htons(ip4port),
-	 uip_htons(ip6port));
   check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
-    printf("protocol %d %d, ip4port %d %d, ip6port %d %d, ip4 %d ip6 %d\n",
-	   m->protocol, protocol,
-	   m->ip4port, ip4port,
-	   m->ip6port, ip6port,
-	   uip_ip4addr_cmp(&m->ip4addr, ip4addr),
-	   uip_ip6addr_cmp(&m->ip6addr, ip6addr));
+  for(m = flow_hash[flow_hash_index(ip6addr, ip6port, ip4addr, ip4port,
+                                    protocol)];
+      m != NULL;
+      m = m->flow_next) {
     if(m->protocol == protocol &&
        m->ip4port == ip4port &&
        m->ip6port == ip6port &&
        uip_ip4addr_cmp(&m->ip4addr, ip4addr) &&
        uip_ip6addr_cmp(&m->ip6addr, ip6addr)) {
-      return m;
+      return live_entry(m);
     }
   }
   return NULL;
@@ -160,18 +385,30 @@ ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
   struct ip64_addrmap_entry *m;
 
   check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
-    printf("mapped port %d %d, protocol %d %d\n",
-	   m->mapped_port, mapped_port,
-	   m->protocol, protocol);
+  for(m = port_hash[port_hash_index(mapped_port)];
+      m != NULL;
+      m = m->port_next) {
     if(m->mapped_port == mapped_port &&
        m->protocol == protocol) {
-      return m;
+      return live_entry(m);
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static int
+mapped_port_in_use(uint16_t port)
+{
+  struct ip64_addrmap_entry *m;
+
+  for(m = port_hash[port_hash_index(port)]; m != NULL; m = m->port_next) {
+    if(m->mapped_port == port) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 static void
 increase_mapped_port(void)
 {
@@ -206,27 +443,20 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
     m->flags = FLAGS_NONE;
     timer_set(&m->timer, 0);
 
-    /* Pick a new, unused local port. First make sure that the
-       mapped_port number does not belong to any active connection. If
-       so, we keep increasing the mapped_port until we're free. */
-    {
-      struct ip64_addrmap_entry *n;
-      n = list_head(entrylist);
-      while(n != NULL) {
-	if(n->mapped_port == mapped_port) {
-	  increase_mapped_port();
-	  n = list_head(entrylist);
-	} else {
-	  n = list_item_next(m);
-	}
-      }
+    /* Pick a new, unused local port. If the mapped_port number
+       belongs to an active connection, we keep picking a new one
+       until it is free. */
+    while(mapped_port_in_use(mapped_port)) {
+      increase_mapped_port();
     }
     m->mapped_port = mapped_port;
     increase_mapped_port();
 
-    list_add(entrylist, m);
+    add_entry(m);
     return m;
   }
+  PRINTF("ip64-addrmap: table full\n");
+  STATS_ADD(failed, 1);
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
@@ -234,8 +464,18 @@ void
 ip64_addrmap_set_lifetime(struct ip64_addrmap_entry *e,
                           clock_time_t time)
 {
+  uint8_t slot;
+
   if(e != NULL) {
     timer_set(&e->timer, time);
+    /* A longer lifetime is noticed when the old slot is due, but a
+       shorter one moves the mapping to an earlier slot now. */
+    slot = wheel_slot(e);
+    if(((slot - wheel_pos) & (WHEEL_SLOTS - 1)) <
+       ((e->wheel_slot - wheel_pos) & (WHEEL_SLOTS - 1))) {
+      wheel_remove(e);
+      wheel_add(e);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
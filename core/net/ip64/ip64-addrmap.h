@@ -37,6 +37,9 @@
 
 struct ip64_addrmap_entry {
   struct ip64_addrmap_entry *next;
+  struct ip64_addrmap_entry *flow_next;
+  struct ip64_addrmap_entry *port_next;
+  struct ip64_addrmap_entry *wheel_next;
   struct timer timer;
   uip_ip6addr_t ip6addr;
   uip_ip4addr_t ip4addr;
@@ -45,11 +48,41 @@ struct ip64_addrmap_entry {
   uint16_t ip4port;
   uint8_t protocol;
   uint8_t flags;
+  uint8_t wheel_slot;
 };
 
 #define FLAGS_NONE       0
 #define FLAGS_RECYCLABLE 1
 
+#ifdef IP64_ADDRMAP_CONF_STATS
+#define IP64_ADDRMAP_STATS IP64_ADDRMAP_CONF_STATS
+#else /* IP64_ADDRMAP_CONF_STATS */
+#define IP64_ADDRMAP_STATS 0
+#endif /* IP64_ADDRMAP_CONF_STATS */
+
+#if IP64_ADDRMAP_STATS
+/**
+ * Statistics of the address mappings.
+ */
+struct ip64_addrmap_stats {
+  /** The number of address mappings currently in use. */
+  uint16_t flows;
+  /** The highest number of address mappings in use at the same time. */
+  uint16_t max_flows;
+  /** The number of address mappings created. */
+  unsigned long created;
+  /** The number of address mappings removed when their lifetime ended. */
+  unsigned long expired;
+  /** The number of recyclable address mappings evicted to make room
+      for a new one. */
+  unsigned long recycled;
+  /** The number of address mappings that could not be created because
+      the table was full. */
+  unsigned long failed;
+};
+extern struct ip64_addrmap_stats ip64_addrmap_stats;
+#endif /* IP64_ADDRMAP_STATS */
+
 /**
  * Initialize the ip64_addrmap module.
  */
@@ -63,6 +63,7 @@
 #include "contiki-net.h"
 
 #include "net/ip/uip-debug.h"
+#include "net/ip/uip-chksum.h"
 
 #include <string.h> /* for memcpy() */
 #include <stdio.h> /* for printf() */
@@ -265,42 +266,11 @@ ip64_set_ipv6_address(const uip_ip6addr_t *addr)
 }
 /*---------------------------------------------------------------------------*/
 static uint16_t
-chksum(uint16_t sum, const uint8_t *data, uint16_t len)
-{
-  uint16_t t;
-  const uint8_t *dataptr;
-  const uint8_t *last_byte;
-
-  dataptr = data;
-  last_byte = data + len - 1;
-
-  while(dataptr < last_byte) {	/* At least two more bytes */
-    t = (dataptr[0] << 8) + dataptr[1];
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-    dataptr += 2;
-  }
-
-  if(dataptr == last_byte) {
-    t = (dataptr[0] << 8) + 0;
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-  }
-
-  /* Return sum in host byte order. */
-  return sum;
-}
-/*---------------------------------------------------------------------------*/
-static uint16_t
 ipv4_checksum(struct ipv4_hdr *hdr)
 {
   uint16_t sum;
 
-  sum = chksum(0, (uint8_t *)hdr, IPV4_HDRLEN);
+  sum = uip_chksum_add(0, (uint8_t *)hdr, IPV4_HDRLEN);
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
@@ -319,14 +289,14 @@ ipv4_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
     /* IP protocol and length fields. This addition cannot carry. */
     sum = transport_layer_len + proto;
     /* Sum IP source and destination addresses. */
-    sum = chksum(sum, (uint8_t *)&v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t));
+    sum = uip_chksum_add(sum, (uint8_t *)&v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t));
   } else {
     /* ping replies' checksums are calculated over the icmp-part only */
     sum = 0;
   }
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV4_HDRLEN], transport_layer_len);
+  sum = uip_chksum_add(sum, &packet[IPV4_HDRLEN], transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
@@ -345,15 +315,38 @@ ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
   /* IP protocol and length fields. This addition cannot carry. */
   sum = transport_layer_len + proto;
   /* Sum IP source and destination addresses. */
-  sum = chksum(sum, (uint8_t *)&v6hdr->srcipaddr, sizeof(uip_ip6addr_t));
-  sum = chksum(sum, (uint8_t *)&v6hdr->destipaddr, sizeof(uip_ip6addr_t));
+  sum = uip_chksum_add(sum, (uint8_t *)&v6hdr->srcipaddr, sizeof(uip_ip6addr_t));
+  sum = uip_chksum_add(sum, (uint8_t *)&v6hdr->destipaddr, sizeof(uip_ip6addr_t));
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV6_HDRLEN], transport_layer_len);
+  sum = uip_chksum_add(sum, &packet[IPV6_HDRLEN], transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+translate_transport_checksum(uint16_t chksum,
+                             const uint8_t *oldaddrs, uint16_t oldaddrs_len,
+                             const uint8_t *oldports,
+                             const uint8_t *newaddrs, uint16_t newaddrs_len,
+                             const uint8_t *newports)
+{
+  uint16_t old_sum;
+  uint16_t new_sum;
+
+  /* The transport layer length and the protocol are the same in the
+     IPv4 and IPv6 pseudoheaders, so only the addresses and the port
+     numbers have changed. Instead of summing the whole packet again,
+     we adjust the checksum for these (RFC 1624). This also keeps a
+     bad checksum bad, so that the receiver can detect the error. */
+  old_sum = uip_chksum_add(0, oldaddrs, oldaddrs_len);
+  old_sum = uip_chksum_add(old_sum, oldports, 4);
+  new_sum = uip_chksum_add(0, newaddrs, newaddrs_len);
+  new_sum = uip_chksum_add(new_sum, newports, 4);
+
+  return uip_htons(uip_chksum_adjust(uip_ntohs(chksum), old_sum, new_sum));
+}
+/*---------------------------------------------------------------------------*/
 int
 ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 	  uint8_t *resultpacket)
@@ -421,26 +414,24 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     PRINTF("ip64_6to4: TCP header\n");
     v4hdr->proto = IP_PROTO_TCP;
 
-    /* Compute and check the TCP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
+#if DEBUG
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_TCP) != 0xffff) {
-      PRINTF("Bad TCP checksum, dropping packet\n");
+      PRINTF("Bad TCP checksum\n");
     }
+#endif /* DEBUG */
 
     break;
 
   case IP_PROTO_UDP:
     PRINTF("ip64_6to4: UDP header\n");
     v4hdr->proto = IP_PROTO_UDP;
-    /* Compute and check the UDP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
+#if DEBUG
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_UDP) != 0xffff) {
-      PRINTF("Bad UDP checksum, dropping packet\n");
+      PRINTF("Bad UDP checksum\n");
     }
+#endif /* DEBUG */
     break;
 
   case IP_PROTO_ICMPV6:
@@ -597,14 +588,29 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
      field. */
   switch(v4hdr->proto) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      translate_transport_checksum(tcphdr->tcpchksum,
+                                   (uint8_t *)&v6hdr->srcipaddr,
+                                   2 * sizeof(uip_ip6addr_t),
+                                   &ipv6packet[IPV6_HDRLEN],
+                                   (uint8_t *)&v4hdr->srcipaddr,
+                                   2 * sizeof(uip_ip4addr_t),
+                                   (uint8_t *)tcphdr);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_UDP));
+    if(udphdr->udpchksum != 0) {
+      udphdr->udpchksum =
+        translate_transport_checksum(udphdr->udpchksum,
+                                     (uint8_t *)&v6hdr->srcipaddr,
+                                     2 * sizeof(uip_ip6addr_t),
+                                     &ipv6packet[IPV6_HDRLEN],
+                                     (uint8_t *)&v4hdr->srcipaddr,
+                                     2 * sizeof(uip_ip4addr_t),
+                                     (uint8_t *)udphdr);
+    } else {
+      udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
+						    IP_PROTO_UDP));
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
@@ -817,16 +823,32 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
      field. */
   switch(v6hdr->nxthdr) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      translate_transport_checksum(tcphdr->tcpchksum,
+                                   (uint8_t *)&v4hdr->srcipaddr,
+                                   2 * sizeof(uip_ip4addr_t),
+                                   &ipv4packet[IPV4_HDRLEN],
+                                   (uint8_t *)&v6hdr->srcipaddr,
+                                   2 * sizeof(uip_ip6addr_t),
+                                   (uint8_t *)tcphdr);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_UDP));
+    /* A zero UDP checksum means that the IPv4 sender did not compute
+       one, but it is mandatory in IPv6. */
+    if(udphdr->udpchksum != 0) {
+      udphdr->udpchksum =
+        translate_transport_checksum(udphdr->udpchksum,
+                                     (uint8_t *)&v4hdr->srcipaddr,
+                                     2 * sizeof(uip_ip4addr_t),
+                                     &ipv4packet[IPV4_HDRLEN],
+                                     (uint8_t *)&v6hdr->srcipaddr,
+                                     2 * sizeof(uip_ip6addr_t),
+                                     (uint8_t *)udphdr);
+    } else {
+      udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
+						    ipv6len,
+						    IP_PROTO_UDP));
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
@@ -223,33 +223,48 @@ static int last_tx_status;
 
 static uint16_t sicslowpan_len;
 
+/** Number of 8-byte units in the largest datagram that fits in uip_buf */
+#define REASS_UNITS ((UIP_BUFSIZE + 7) / 8)
+
 /**
- * The buffer used for the 6lowpan reassembly.
- * This buffer contains only the IPv6 packet (no MAC header, 6lowpan, etc).
- * It has a fix size as we do not use dynamic memory allocation.
+ * A datagram being reassembled. The buffer contains only the IPv6
+ * packet (no MAC header, 6lowpan, etc). The map has one bit per 8-byte
+ * unit of the IPv6 packet, set when the unit has been received, as
+ * fragment offsets and sizes are in multiples of 8 bytes.
  */
-static uip_buf_t sicslowpan_aligned_buf;
-#define sicslowpan_buf (sicslowpan_aligned_buf.u8)
+struct reass_context {
+  uip_buf_t buf;
+  linkaddr_t sender;
+  struct timer timer;
+  /** The size of the IPv6 packet, or 0 if the context is unused */
+  uint16_t size;
+  uint16_t tag;
+  /** The number of units received so far */
+  uint16_t units;
+  uint8_t map[(REASS_UNITS + 7) / 8];
+};
 
-/** The total length of the IPv6 packet in the sicslowpan_buf. */
+static struct reass_context reass_contexts[SICSLOWPAN_REASS_CONTEXTS];
 
 /**
- * length of the ip packet already sent / received.
- * It includes IP and transport headers.
+ * The buffer used for 6lowpan decompression: the buffer of the
+ * datagram being reassembled, or uip_buf for a packet that is not
+ * fragmented. The headers of a first fragment are uncompressed in
+ * uip_buf, and copied to the buffer of the datagram once the fragment
+ * has been found valid.
  */
-static uint16_t processed_ip_in_len;
+static uip_buf_t *sicslowpan_cur_buf = &uip_aligned_buf;
+#define sicslowpan_buf (sicslowpan_cur_buf->u8)
 
 /** Datagram tag to be put in the fragments I send. */
 static uint16_t my_tag;
 
-/** When reassembling, the tag in the fragments being merged. */
-static uint16_t reass_tag;
-
-/** When reassembling, the source address of the fragments being merged */
-linkaddr_t frag_sender;
-
-/** Reassembly %process %timer. */
-static struct timer reass_timer;
+#if SICSLOWPAN_CONF_REASS_STATS
+struct sicslowpan_reass_stats sicslowpan_reass_stats;
+#define REASS_STATS(x) sicslowpan_reass_stats.x++
+#else /* SICSLOWPAN_CONF_REASS_STATS */
+#define REASS_STATS(x)
+#endif /* SICSLOWPAN_CONF_REASS_STATS */
 
 /** @} */
 #else /* SICSLOWPAN_CONF_FRAG */
@@ -1371,6 +1386,11 @@ output(const uip_lladdr_t *localdest)
   /* Number of bytes processed. */
   uint16_t processed_ip_out_len;
 
+#if SICSLOWPAN_CONF_FRAG
+  /* Non-zero if room was left for the FRAG1 header */
+  uint8_t frag1_reserved;
+#endif /* SICSLOWPAN_CONF_FRAG */
+
   /* init */
   uncomp_hdr_len = 0;
   packetbuf_hdr_len = 0;
@@ -1416,22 +1436,6 @@ output(const uip_lladdr_t *localdest)
   
   PRINTFO("sicslowpan output: sending packet len %d\n", uip_len);
 
-  if(uip_len >= COMPRESSION_THRESHOLD) {
-    /* Try to compress the headers */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1
-    compress_hdr_hc1(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1 */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
-    compress_hdr_ipv6(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
-    compress_hdr_hc06(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
-  } else {
-    compress_hdr_ipv6(&dest);
-  }
-  PRINTFO("sicslowpan output: header of len %d\n", packetbuf_hdr_len);
-
   /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_RDC.
    * We calculate it here only to make a better decision of whether the outgoing packet
    * needs to be fragmented or not. */
@@ -1448,6 +1452,32 @@ output(const uip_lladdr_t *localdest)
 #endif /* USE_FRAMER_HDRLEN */
   max_payload = MAC_MAX_PAYLOAD - framer_hdrlen - NETSTACK_LLSEC.get_overhead();
 
+#if SICSLOWPAN_CONF_FRAG
+  /* If the packet will probably be fragmented, leave room for the
+     FRAG1 header before the compressed headers, so that they do not
+     have to be moved when it is inserted. */
+  frag1_reserved = (int)uip_len > max_payload;
+  if(frag1_reserved) {
+    packetbuf_ptr += SICSLOWPAN_FRAG1_HDR_LEN;
+  }
+#endif /* SICSLOWPAN_CONF_FRAG */
+
+  if(uip_len >= COMPRESSION_THRESHOLD) {
+    /* Try to compress the headers */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1
+    compress_hdr_hc1(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
+    compress_hdr_ipv6(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+    compress_hdr_hc06(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
+  } else {
+    compress_hdr_ipv6(&dest);
+  }
+  PRINTFO("sicslowpan output: header of len %d\n", packetbuf_hdr_len);
+
   if((int)uip_len - (int)uncomp_hdr_len > max_payload - (int)packetbuf_hdr_len) {
 #if SICSLOWPAN_CONF_FRAG
     struct queuebuf *q;
@@ -1471,8 +1501,12 @@ output(const uip_lladdr_t *localdest)
     /* Create 1st Fragment */
     PRINTFO("sicslowpan output: 1rst fragment ");
 
-    /* move HC1/HC06/IPv6 header */
-    memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+    if(frag1_reserved) {
+      packetbuf_ptr -= SICSLOWPAN_FRAG1_HDR_LEN;
+    } else {
+      /* move HC1/HC06/IPv6 header */
+      memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+    }
 
     /*
      * FRAG1 dispatch + header
@@ -1568,6 +1602,13 @@ output(const uip_lladdr_t *localdest)
      * The packet does not need to be fragmented
      * copy "payload" and send
      */
+#if SICSLOWPAN_CONF_FRAG
+    if(frag1_reserved) {
+      /* The headers compressed better than expected */
+      memmove(packetbuf_ptr - SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+      packetbuf_ptr -= SICSLOWPAN_FRAG1_HDR_LEN;
+    }
+#endif /* SICSLOWPAN_CONF_FRAG */
     memcpy(packetbuf_ptr + packetbuf_hdr_len, (uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
            uip_len - uncomp_hdr_len);
     packetbuf_set_datalen(uip_len - uncomp_hdr_len + packetbuf_hdr_len);
@@ -1576,6 +1617,121 @@ output(const uip_lladdr_t *localdest)
   return 1;
 }
 
+#if SICSLOWPAN_CONF_FRAG
+/*--------------------------------------------------------------------*/
+/** \name Fragment reassembly
+ * @{
+ */
+/*--------------------------------------------------------------------*/
+/** \brief Drop the datagrams that have not been completed in time */
+static void
+reass_expire(void)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(reass_contexts[i].size != 0 && timer_expired(&reass_contexts[i].timer)) {
+      PRINTFI("sicslowpan input: reassembly timeout (tag %d)\n",
+              reass_contexts[i].tag);
+      reass_contexts[i].size = 0;
+      REASS_STATS(timeouts);
+    }
+  }
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Find the datagram a fragment belongs to, or start a new one
+ * \param size The size of the IPv6 packet, from the fragment header
+ * \param tag The datagram tag, from the fragment header
+ * \return The reassembly context of the datagram
+ *
+ * The sender of the fragment is taken from packetbuf. When all contexts
+ * are busy, the oldest datagram is dropped, as a new datagram is more
+ * likely to be completed than one that has been waiting for a while.
+ */
+static struct reass_context *
+reass_get(uint16_t size, uint16_t tag)
+{
+  const linkaddr_t *sender = packetbuf_addr(PACKETBUF_ADDR_SENDER);
+  struct reass_context *r, *free, *oldest;
+  int i;
+
+  free = oldest = NULL;
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    r = &reass_contexts[i];
+    if(r->size == 0) {
+      if(free == NULL) {
+        free = r;
+      }
+    } else if(r->size == size && r->tag == tag &&
+              linkaddr_cmp(&r->sender, sender)) {
+      return r;
+    } else if(oldest == NULL ||
+              timer_remaining(&r->timer) < timer_remaining(&oldest->timer)) {
+      oldest = r;
+    }
+  }
+
+  if(free == NULL) {
+    PRINTFI("sicslowpan input: dropping datagram (tag %d) being reassembled\n",
+            oldest->tag);
+    REASS_STATS(evicted);
+    free = oldest;
+  }
+
+  PRINTFI("sicslowpan input: INIT FRAGMENTATION (len %d, tag %d)\n",
+          size, tag);
+  free->size = size;
+  free->tag = tag;
+  free->units = 0;
+  memset(free->map, 0, sizeof(free->map));
+  linkaddr_copy(&free->sender, sender);
+  timer_set(&free->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND);
+  return free;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Record that part of a datagram has been received
+ * \param r The reassembly context
+ * \param offset The offset of the part in the IPv6 packet
+ * \param len The length of the part
+ * \return Zero if the part overlaps a part already received, or
+ *         starts past the end of the packet
+ *
+ * Only the 8-byte units that the part covers completely are recorded,
+ * except at the end of the packet, where any extraneous bytes are
+ * ignored.
+ */
+static int
+reass_mark(struct reass_context *r, uint16_t offset, uint16_t len)
+{
+  uint16_t first, last, u;
+
+  first = (offset + 7) / 8;
+  if(offset + len >= r->size) {
+    last = (r->size + 7) / 8;
+  } else {
+    last = (offset + len) / 8;
+  }
+  if(first > last) {
+    /* The part starts past the end of the packet */
+    return 0;
+  }
+
+  for(u = first; u < last; u++) {
+    if(r->map[u / 8] & (1 << (u % 8))) {
+      return 0;
+    }
+  }
+  for(u = first; u < last; u++) {
+    r->map[u / 8] |= 1 << (u % 8);
+  }
+  r->units += last - first;
+  return 1;
+}
+/** @} */
+#endif /* SICSLOWPAN_CONF_FRAG */
+
 /*--------------------------------------------------------------------*/
 /** \brief Process a received 6lowpan packet.
  *  \param r The MAC layer
@@ -1583,11 +1739,12 @@ output(const uip_lladdr_t *localdest)
  *  The 6lowpan packet is put in packetbuf by the MAC. If its a frag1 or
  *  a non-fragmented packet we first uncompress the IP header. The
  *  6lowpan payload and possibly the uncompressed IP header are then
- *  copied in siclowpan_buf. If the IP packet is complete it is copied
- *  to uip_buf and the IP layer is called.
+ *  copied in siclowpan_buf, which is the reassembly buffer of the
+ *  datagram for a fragment and uip_buf otherwise. If the IP packet is
+ *  complete it is copied to uip_buf and the IP layer is called.
  *
- * \note We do not check for overlapping sicslowpan fragments
- * (it is a SHALL in the RFC 4944 and should never happen)
+ * \note Fragments that overlap a part of the datagram already received
+ * are dropped.
  */
 static void
 input(void)
@@ -1600,7 +1757,8 @@ input(void)
 #if SICSLOWPAN_CONF_FRAG
   /* tag of the fragment */
   uint16_t frag_tag = 0;
-  uint8_t first_fragment = 0, last_fragment = 0;
+  /* the datagram the fragment belongs to */
+  struct reass_context *reass = NULL;
 #endif /*SICSLOWPAN_CONF_FRAG*/
 
   /* init */
@@ -1614,11 +1772,11 @@ input(void)
      want to query us for it later. */
   last_rssi = (signed short)packetbuf_attr(PACKETBUF_ATTR_RSSI);
 #if SICSLOWPAN_CONF_FRAG
-  /* if reassembly timed out, cancel it */
-  if(timer_expired(&reass_timer)) {
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
-  }
+  /* Packets that are not fragmented are uncompressed directly into
+     uip_buf */
+  sicslowpan_cur_buf = &uip_aligned_buf;
+
+  reass_expire();
   /*
    * Since we don't support the mesh and broadcast header, the first header
    * we look for is the fragmentation header
@@ -1634,8 +1792,6 @@ input(void)
       PRINTFI("size %d, tag %d, offset %d)\n",
              frag_size, frag_tag, frag_offset);
       packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
-      /*      printf("frag1 %d %d\n", reass_tag, frag_tag);*/
-      first_fragment = 1;
       is_fragment = 1;
       break;
     case SICSLOWPAN_DISPATCH_FRAGN:
@@ -1650,77 +1806,19 @@ input(void)
       PRINTFI("size %d, tag %d, offset %d)\n",
              frag_size, frag_tag, frag_offset);
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
-
-      /* If this is the last fragment, we may shave off any extrenous
-         bytes at the end. We must be liberal in what we accept. */
-      PRINTFI("last_fragment?: processed_ip_in_len %d packetbuf_payload_len %d frag_size %d\n",
-              processed_ip_in_len, packetbuf_datalen() - packetbuf_hdr_len, frag_size);
-
-      if(processed_ip_in_len + packetbuf_datalen() - packetbuf_hdr_len >= frag_size) {
-        last_fragment = 1;
-      }
       is_fragment = 1;
       break;
     default:
       break;
   }
 
-  /* We are currently reassembling a packet, but have just received the first
-   * fragment of another packet. We can either ignore it and hope to receive
-   * the rest of the under-reassembly packet fragments, or we can discard the
-   * previous packet altogether, and start reassembling the new packet.
-   *
-   * We discard the previous packet, and start reassembling the new packet.
-   * This lessens the negative impacts of too high SICSLOWPAN_REASS_MAXAGE.
-   */
-#define PRIORITIZE_NEW_PACKETS 1
-#if PRIORITIZE_NEW_PACKETS
-
-  if(!is_fragment) {
-    /* Prioritize non-fragment packets too. */
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
-  } else if(processed_ip_in_len > 0 && first_fragment
-      && !linkaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
-  }
-#endif /* PRIORITIZE_NEW_PACKETS */
-
-  if(processed_ip_in_len > 0) {
-    /* reassembly is ongoing */
-    /*    printf("frag %d %d\n", reass_tag, frag_tag);*/
-    if((frag_size > 0 &&
-        (frag_size != sicslowpan_len ||
-         reass_tag  != frag_tag ||
-         !linkaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))))  ||
-       frag_size == 0) {
-      /*
-       * the packet is a fragment that does not belong to the packet
-       * being reassembled or the packet is not a fragment.
-       */
-      PRINTFI("sicslowpan input: Dropping 6lowpan packet that is not a fragment of the packet currently being reassembled\n");
+  if(is_fragment) {
+    if(frag_size == 0 || frag_size > UIP_BUFSIZE - UIP_LLH_LEN) {
+      PRINTFI("sicslowpan input: Dropping fragment of invalid size %d\n",
+              frag_size);
+      REASS_STATS(dropped);
       return;
     }
-  } else {
-    /*
-     * reassembly is off
-     * start it if we received a fragment
-     */
-    if((frag_size > 0) && (frag_size <= UIP_BUFSIZE)) {
-      /* We are currently not reassembling a packet, but have received a packet fragment
-       * that is not the first one. */
-      if(is_fragment && !first_fragment) {
-        return;
-      }
-
-      sicslowpan_len = frag_size;
-      reass_tag = frag_tag;
-      timer_set(&reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND);
-      PRINTFI("sicslowpan input: INIT FRAGMENTATION (len %d, tag %d)\n",
-             sicslowpan_len, reass_tag);
-      linkaddr_copy(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    }
   }
 
   if(packetbuf_hdr_len == SICSLOWPAN_FRAGN_HDR_LEN) {
@@ -1787,29 +1885,62 @@ input(void)
           "SICSLOWPAN: packet dropped, minimum required SICSLOWPAN_IP_BUF size: %d+%d+%d+%d=%d (current size: %d)\n",
           UIP_LLH_LEN, uncomp_hdr_len, (uint16_t)(frag_offset << 3),
           packetbuf_payload_len, req_size, sizeof(sicslowpan_buf));
+#if SICSLOWPAN_CONF_FRAG
+      if(is_fragment) {
+        REASS_STATS(dropped);
+      }
+#endif /* SICSLOWPAN_CONF_FRAG */
+      return;
+    }
+  }
+
+#if SICSLOWPAN_CONF_FRAG
+  if(is_fragment) {
+    /* The last fragment may carry up to 7 bytes past the end of the
+       packet, which are ignored; anything further is invalid */
+    if((uint16_t)(frag_offset << 3) + uncomp_hdr_len + packetbuf_payload_len >
+       frag_size + 7) {
+      PRINTFI("sicslowpan input: Dropping fragment past end of datagram (tag %d, offset %d)\n",
+              frag_tag, frag_offset);
+      REASS_STATS(dropped);
       return;
     }
+
+    /* Only a valid fragment may take a reassembly context. Fragments
+       may arrive in any order; each is copied to its place in the
+       buffer of its datagram. */
+    reass = reass_get(frag_size, frag_tag);
+    if(!reass_mark(reass, (uint16_t)(frag_offset << 3),
+                   uncomp_hdr_len + packetbuf_payload_len)) {
+      PRINTFI("sicslowpan input: Dropping duplicate fragment (tag %d, offset %d)\n",
+              frag_tag, frag_offset);
+      REASS_STATS(dropped);
+      return;
+    }
+    if(uncomp_hdr_len > 0) {
+      /* The headers of a first fragment were uncompressed in uip_buf */
+      memcpy(&reass->buf.u8[UIP_LLH_LEN], (uint8_t *)SICSLOWPAN_IP_BUF,
+             uncomp_hdr_len);
+    }
+    sicslowpan_cur_buf = &reass->buf;
   }
+#endif /* SICSLOWPAN_CONF_FRAG */
 
   memcpy((uint8_t *)SICSLOWPAN_IP_BUF + uncomp_hdr_len + (uint16_t)(frag_offset << 3), packetbuf_ptr + packetbuf_hdr_len, packetbuf_payload_len);
   
-  /* update processed_ip_in_len if fragment, sicslowpan_len otherwise */
+  /* update the reassembly state if fragment, sicslowpan_len otherwise */
 
 #if SICSLOWPAN_CONF_FRAG
-  if(frag_size > 0) {
-    /* Add the size of the header only for the first fragment. */
-    if(first_fragment != 0) {
-      processed_ip_in_len += uncomp_hdr_len;
-    }
-    /* For the last fragment, we are OK if there is extrenous bytes at
-       the end of the packet. */
-    if(last_fragment != 0) {
-      processed_ip_in_len = frag_size;
-    } else {
-      processed_ip_in_len += packetbuf_payload_len;
+  if(reass != NULL) {
+    PRINTF("reassembly units %d of %d\n", reass->units,
+           (reass->size + 7) / 8);
+    if(reass->units < (reass->size + 7) / 8) {
+      /* Wait for more fragments */
+      return;
     }
-    PRINTF("processed_ip_in_len %d, packetbuf_payload_len %d\n", processed_ip_in_len, packetbuf_payload_len);
-
+    sicslowpan_len = reass->size;
+    reass->size = 0;
+    REASS_STATS(completed);
   } else {
 #endif /* SICSLOWPAN_CONF_FRAG */
     sicslowpan_len = packetbuf_payload_len + uncomp_hdr_len;
@@ -1817,42 +1948,38 @@ input(void)
   }
 
   /*
-   * If we have a full IP packet in sicslowpan_buf, deliver it to
+   * We have a full IP packet in sicslowpan_buf, deliver it to
    * the IP stack
    */
-  PRINTF("sicslowpan_init processed_ip_in_len %d, sicslowpan_len %d\n",
-         processed_ip_in_len, sicslowpan_len);
-  if(processed_ip_in_len == 0 || (processed_ip_in_len == sicslowpan_len)) {
-    PRINTFI("sicslowpan input: IP packet ready (length %d)\n",
-           sicslowpan_len);
+  PRINTFI("sicslowpan input: IP packet ready (length %d)\n",
+         sicslowpan_len);
+  if(sicslowpan_cur_buf != &uip_aligned_buf) {
     memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)SICSLOWPAN_IP_BUF, sicslowpan_len);
-    uip_len = sicslowpan_len;
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
+    sicslowpan_cur_buf = &uip_aligned_buf;
+  }
+  uip_len = sicslowpan_len;
+  sicslowpan_len = 0;
 #endif /* SICSLOWPAN_CONF_FRAG */
 
 #if DEBUG
-    {
-      uint16_t ndx;
-      PRINTF("after decompression %u:", SICSLOWPAN_IP_BUF->len[1]);
-      for (ndx = 0; ndx < SICSLOWPAN_IP_BUF->len[1] + 40; ndx++) {
-        uint8_t data = ((uint8_t *) (SICSLOWPAN_IP_BUF))[ndx];
-        PRINTF("%02x", data);
-      }
-      PRINTF("\n");
+  {
+    uint16_t ndx;
+    PRINTF("after decompression %u:", SICSLOWPAN_IP_BUF->len[1]);
+    for (ndx = 0; ndx < SICSLOWPAN_IP_BUF->len[1] + 40; ndx++) {
+      uint8_t data = ((uint8_t *) (SICSLOWPAN_IP_BUF))[ndx];
+      PRINTF("%02x", data);
     }
+    PRINTF("\n");
+  }
 #endif
 
-    /* if callback is set then set attributes and call */
-    if(callback) {
-      set_packet_attrs();
-      callback->input_callback();
-    }
-
-    tcpip_input();
-#if SICSLOWPAN_CONF_FRAG
+  /* if callback is set then set attributes and call */
+  if(callback) {
+    set_packet_attrs();
+    callback->input_callback();
   }
-#endif /* SICSLOWPAN_CONF_FRAG */
+
+  tcpip_input();
 }
 /** @} */
 
@@ -319,6 +319,25 @@ struct sicslowpan_nh_compressor {
 
 };
 
+#if SICSLOWPAN_CONF_REASS_STATS
+/**
+ * Statistics of 6lowpan fragment reassembly.
+ */
+struct sicslowpan_reass_stats {
+  /** The number of datagrams reassembled and delivered. */
+  unsigned long completed;
+  /** The number of datagrams dropped because they were not complete
+      within SICSLOWPAN_REASS_MAXAGE seconds. */
+  unsigned long timeouts;
+  /** The number of datagrams dropped to make room for a new one. */
+  unsigned long evicted;
+  /** The number of fragments dropped because they were invalid,
+      duplicated or did not fit in the reassembly buffer. */
+  unsigned long dropped;
+};
+extern struct sicslowpan_reass_stats sicslowpan_reass_stats;
+#endif /* SICSLOWPAN_CONF_REASS_STATS */
+
 int sicslowpan_get_last_rssi(void);
 
 extern const struct network_driver sicslowpan_driver;
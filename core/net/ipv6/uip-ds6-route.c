@@ -34,6 +34,7 @@
 
 #include "lib/list.h"
 #include "lib/memb.h"
+#include "lib/hash-index.h"
 #include "net/nbr-table.h"
 
 #include <string.h>
@@ -63,6 +64,29 @@ LIST(notificationlist);
 
 static int num_routes = 0;
 
+#if UIP_DS6_ROUTE_HASH_SIZE
+#if (UIP_DS6_ROUTE_HASH_SIZE & (UIP_DS6_ROUTE_HASH_SIZE - 1)) != 0
+#error UIP_CONF_DS6_ROUTE_HASH_SIZE must be a power of two
+#endif
+#if UIP_DS6_ROUTE_HASH_SIZE <= UIP_DS6_ROUTE_NB
+#error UIP_CONF_DS6_ROUTE_HASH_SIZE must be larger than UIP_DS6_ROUTE_NB
+#endif
+/* Hash index from (prefix, prefix length) to route. Each slot holds
+   the index of the route in routememb plus one. */
+static unsigned route_entry_hash(unsigned entry);
+HASH_INDEX(route_index, UIP_DS6_ROUTE_NB, UIP_DS6_ROUTE_HASH_SIZE,
+           route_entry_hash);
+/* The number of routes with each prefix length, so that lookups only
+   probe the lengths that are in use. */
+#if UIP_DS6_ROUTE_NB < 255
+static uint8_t length_count[129];
+#else
+static uint16_t length_count[129];
+#endif
+#define ROUTE_FROM_ENTRY(e) ((uip_ds6_route_t *)routememb.mem + (e) - 1)
+#define ENTRY_FROM_ROUTE(r) ((r) - (uip_ds6_route_t *)routememb.mem + 1)
+#endif /* UIP_DS6_ROUTE_HASH_SIZE */
+
 #undef DEBUG
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
@@ -97,6 +121,79 @@ assert_nbr_routes_list_sane(void)
 }
 #endif /* DEBUG != DEBUG_NONE */
 /*---------------------------------------------------------------------------*/
+#if UIP_DS6_ROUTE_HASH_SIZE
+/* Get the hash of a prefix. Like uip_ipaddr_prefixcmp(), only the
+   whole bytes of the prefix are significant. The hash is 32-bit
+   FNV-1a, which also spreads routes that only differ in the last few
+   bits of the address. */
+static unsigned
+route_hash(const uip_ipaddr_t *addr, uint8_t length)
+{
+  uint32_t h = 2166136261UL ^ length;
+  int i;
+  for(i = 0; i < (length >> 3); i++) {
+    h = (h ^ addr->u8[i]) * 16777619UL;
+  }
+  return (unsigned)(h ^ (h >> 16));
+}
+/*---------------------------------------------------------------------------*/
+/* Get the hash of the prefix of a route in the hash index */
+static unsigned
+route_entry_hash(unsigned entry)
+{
+  uip_ds6_route_t *r = ROUTE_FROM_ENTRY(entry);
+  return route_hash(&r->ipaddr, r->length);
+}
+/*---------------------------------------------------------------------------*/
+/* Add a route to the hash index */
+static void
+route_hash_insert(uip_ds6_route_t *r)
+{
+  if(r->length > 128) {
+    return;
+  }
+  hash_index_insert(&route_index, ENTRY_FROM_ROUTE(r));
+  length_count[r->length]++;
+}
+/*---------------------------------------------------------------------------*/
+/* Remove a route from the hash index */
+static void
+route_hash_remove(uip_ds6_route_t *r)
+{
+  if(r->length > 128) {
+    return;
+  }
+  if(hash_index_remove(&route_index, ENTRY_FROM_ROUTE(r))) {
+    length_count[r->length]--;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Find the route with the longest prefix matching an address, trying
+   the prefix lengths in use from the longest to the shortest */
+static uip_ds6_route_t *
+route_hash_lookup(const uip_ipaddr_t *addr)
+{
+  uip_ds6_route_t *r;
+  unsigned slot, entry;
+  int length;
+
+  for(length = 128; length >= 0; length--) {
+    if(length_count[length] == 0) {
+      continue;
+    }
+    for(slot = route_hash(addr, length);
+        (entry = hash_index_get(&route_index, slot)) != 0; slot++) {
+      r = ROUTE_FROM_ENTRY(entry);
+      if(r->length == length &&
+         uip_ipaddr_prefixcmp(addr, &r->ipaddr, length)) {
+        return r;
+      }
+    }
+  }
+  return NULL;
+}
+#endif /* UIP_DS6_ROUTE_HASH_SIZE */
+/*---------------------------------------------------------------------------*/
 #if UIP_DS6_NOTIFICATIONS
 static void
 call_route_callback(int event, uip_ipaddr_t *route,
@@ -139,6 +236,10 @@ uip_ds6_route_init(void)
 {
   memb_init(&routememb);
   list_init(routelist);
+#if UIP_DS6_ROUTE_HASH_SIZE
+  hash_index_init(&route_index);
+  memset(length_count, 0, sizeof(length_count));
+#endif /* UIP_DS6_ROUTE_HASH_SIZE */
   nbr_table_register(nbr_routes,
                      (nbr_table_callback *)rm_routelist_callback);
 
@@ -196,15 +297,19 @@ uip_ds6_route_num_routes(void)
 uip_ds6_route_t *
 uip_ds6_route_lookup(uip_ipaddr_t *addr)
 {
+#if !UIP_DS6_ROUTE_HASH_SIZE
   uip_ds6_route_t *r;
-  uip_ds6_route_t *found_route;
   uint8_t longestmatch;
+#endif /* !UIP_DS6_ROUTE_HASH_SIZE */
+  uip_ds6_route_t *found_route;
 
   PRINTF("uip-ds6-route: Looking up route for ");
   PRINT6ADDR(addr);
   PRINTF("\n");
 
-
+#if UIP_DS6_ROUTE_HASH_SIZE
+  found_route = route_hash_lookup(addr);
+#else /* UIP_DS6_ROUTE_HASH_SIZE */
   found_route = NULL;
   longestmatch = 0;
   for(r = uip_ds6_route_head();
@@ -220,6 +325,7 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
       }
     }
   }
+#endif /* UIP_DS6_ROUTE_HASH_SIZE */
 
   if(found_route != NULL) {
     PRINTF("uip-ds6-route: Found route: ");
@@ -231,6 +337,7 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     PRINTF("uip-ds6-route: No route found\n");
   }
 
+#if !UIP_DS6_ROUTE_HASH_SIZE
   if(found_route != NULL && found_route != list_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
@@ -240,6 +347,7 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     list_remove(routelist, found_route);
     list_push(routelist, found_route);
   }
+#endif /* !UIP_DS6_ROUTE_HASH_SIZE */
 
   return found_route;
 }
@@ -355,6 +463,9 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
 
   uip_ipaddr_copy(&(r->ipaddr), ipaddr);
   r->length = length;
+#if UIP_DS6_ROUTE_HASH_SIZE
+  route_hash_insert(r);
+#endif /* UIP_DS6_ROUTE_HASH_SIZE */
 
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   memset(&r->state, 0, sizeof(UIP_DS6_ROUTE_STATE_TYPE));
@@ -393,6 +504,9 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
 
     /* Remove the route from the route list */
     list_remove(routelist, route);
+#if UIP_DS6_ROUTE_HASH_SIZE
+    route_hash_remove(route);
+#endif /* UIP_DS6_ROUTE_HASH_SIZE */
 
     /* Find the corresponding neighbor_route and remove it. */
     for(neighbor_route = list_head(route->neighbor_routes->route_list);
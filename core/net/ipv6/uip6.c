@@ -73,6 +73,7 @@
 
 #include "net/ip/uip.h"
 #include "net/ip/uipopt.h"
+#include "net/ip/uip-chksum.h"
 #include "net/ipv6/uip-icmp6.h"
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
@@ -197,8 +198,12 @@ struct uip_conn *uip_conn;
 
 /* Temporary variables. */
 #if (UIP_TCP || UIP_UDP)
+#if UIP_CONNS > 255 || UIP_UDP_CONNS > 255
+static uint16_t c;
+#else
 static uint8_t c;
 #endif
+#endif
 
 #if UIP_ACTIVE_OPEN || UIP_UDP
 /* Keeps track of the last port used for a new connection. */
@@ -300,41 +305,10 @@ uip_add32(uint8_t *op32, uint16_t op16)
 
 #if ! UIP_ARCH_CHKSUM
 /*---------------------------------------------------------------------------*/
-static uint16_t
-chksum(uint16_t sum, const uint8_t *data, uint16_t len)
-{
-  uint16_t t;
-  const uint8_t *dataptr;
-  const uint8_t *last_byte;
-
-  dataptr = data;
-  last_byte = data + len - 1;
-  
-  while(dataptr < last_byte) {   /* At least two more bytes */
-    t = (dataptr[0] << 8) + dataptr[1];
-    sum += t;
-    if(sum < t) {
-      sum++;      /* carry */
-    }
-    dataptr += 2;
-  }
-  
-  if(dataptr == last_byte) {
-    t = (dataptr[0] << 8) + 0;
-    sum += t;
-    if(sum < t) {
-      sum++;      /* carry */
-    }
-  }
-
-  /* Return sum in host byte order. */
-  return sum;
-}
-/*---------------------------------------------------------------------------*/
 uint16_t
 uip_chksum(uint16_t *data, uint16_t len)
 {
-  return uip_htons(chksum(0, (uint8_t *)data, len));
+  return uip_htons(uip_chksum_add(0, (uint8_t *)data, len));
 }
 /*---------------------------------------------------------------------------*/
 #ifndef UIP_ARCH_IPCHKSUM
@@ -343,7 +317,7 @@ uip_ipchksum(void)
 {
   uint16_t sum;
 
-  sum = chksum(0, &uip_buf[UIP_LLH_LEN], UIP_IPH_LEN);
+  sum = uip_chksum_add(0, &uip_buf[UIP_LLH_LEN], UIP_IPH_LEN);
   PRINTF("uip_ipchksum: sum 0x%04x\n", sum);
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
@@ -373,10 +347,10 @@ upper_layer_chksum(uint8_t proto)
   /* IP protocol and length fields. This addition cannot carry. */
   sum = upper_layer_len + proto;
   /* Sum IP source and destination addresses. */
-  sum = chksum(sum, (uint8_t *)&UIP_IP_BUF->srcipaddr, 2 * sizeof(uip_ipaddr_t));
+  sum = uip_chksum_add(sum, (uint8_t *)&UIP_IP_BUF->srcipaddr, 2 * sizeof(uip_ipaddr_t));
 
   /* Sum TCP header and data. */
-  sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN + uip_ext_len],
+  sum = uip_chksum_add(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN + uip_ext_len],
                upper_layer_len);
     
   return (sum == 0) ? 0xffff : uip_htons(sum);
@@ -406,6 +380,125 @@ uip_udpchksum(void)
 #endif /* UIP_UDP && UIP_UDP_CHECKSUMS */
 #endif /* UIP_ARCH_CHKSUM */
 /*---------------------------------------------------------------------------*/
+#if UIP_DEMUX_HASH_SIZE
+#if (UIP_DEMUX_HASH_SIZE & (UIP_DEMUX_HASH_SIZE - 1)) != 0
+#error "UIP_CONF_DEMUX_HASH_SIZE must be a power of two"
+#endif
+
+/* The connections in each slot of the demultiplexing hash tables are
+   chained through their indices, in ascending order, so that a lookup
+   finds the same connection as a walk through the whole table. */
+#if UIP_CONNS >= 255 || UIP_UDP_CONNS >= 255
+typedef uint16_t demux_index_t;
+#else
+typedef uint8_t demux_index_t;
+#endif
+#define DEMUX_NONE ((demux_index_t)~0)
+#define DEMUX_NO_SLOT 0xffff
+
+static void
+demux_insert(demux_index_t *head, demux_index_t *next, demux_index_t i)
+{
+  while(*head != DEMUX_NONE && *head < i) {
+    head = &next[*head];
+  }
+  next[i] = *head;
+  *head = i;
+}
+/*---------------------------------------------------------------------------*/
+static void
+demux_remove(demux_index_t *head, demux_index_t *next, demux_index_t i)
+{
+  while(*head != DEMUX_NONE) {
+    if(*head == i) {
+      *head = next[i];
+      return;
+    }
+    head = &next[*head];
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_UDP
+static demux_index_t udp_demux[UIP_DEMUX_HASH_SIZE];
+static demux_index_t udp_demux_next[UIP_UDP_CONNS];
+/* The local port each UDP connection is hashed by, or 0. */
+static uint16_t udp_demux_lport[UIP_UDP_CONNS];
+
+static unsigned
+udp_demux_slot(uint16_t lport)
+{
+  return (lport ^ (lport >> 8)) & (UIP_DEMUX_HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_udp_rehash(struct uip_udp_conn *conn)
+{
+  demux_index_t i = conn - uip_udp_conns;
+
+  if(udp_demux_lport[i] == conn->lport) {
+    return;
+  }
+  if(udp_demux_lport[i] != 0) {
+    demux_remove(&udp_demux[udp_demux_slot(udp_demux_lport[i])],
+                 udp_demux_next, i);
+  }
+  if(conn->lport != 0) {
+    demux_insert(&udp_demux[udp_demux_slot(conn->lport)],
+                 udp_demux_next, i);
+  }
+  udp_demux_lport[i] = conn->lport;
+}
+#endif /* UIP_UDP */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP
+static demux_index_t tcp_demux[UIP_DEMUX_HASH_SIZE];
+static demux_index_t tcp_demux_next[UIP_CONNS];
+/* The slot each TCP connection is in, or DEMUX_NO_SLOT. A connection
+   stays in its slot after it has been closed, until it is used
+   again; lookups skip closed connections. */
+static uint16_t tcp_demux_slot_of[UIP_CONNS];
+
+static unsigned
+tcp_demux_slot(uint16_t lport, uint16_t rport, const uip_ipaddr_t *ripaddr)
+{
+  unsigned h;
+
+  h = lport ^ (rport * 31) ^ ripaddr->u16[7] ^ (ripaddr->u16[6] << 3);
+  return (h ^ (h >> 8)) & (UIP_DEMUX_HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_rehash(struct uip_conn *conn)
+{
+  demux_index_t i = conn - uip_conns;
+  uint16_t slot;
+
+  slot = tcp_demux_slot(conn->lport, conn->rport, &conn->ripaddr);
+  if(tcp_demux_slot_of[i] == slot) {
+    return;
+  }
+  if(tcp_demux_slot_of[i] != DEMUX_NO_SLOT) {
+    demux_remove(&tcp_demux[tcp_demux_slot_of[i]], tcp_demux_next, i);
+  }
+  demux_insert(&tcp_demux[slot], tcp_demux_next, i);
+  tcp_demux_slot_of[i] = slot;
+}
+#endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
+static void
+demux_init(void)
+{
+#if UIP_UDP
+  memset(udp_demux, 0xff, sizeof(udp_demux));
+  memset(udp_demux_lport, 0, sizeof(udp_demux_lport));
+#endif /* UIP_UDP */
+#if UIP_TCP
+  memset(tcp_demux, 0xff, sizeof(tcp_demux));
+  memset(tcp_demux_slot_of, 0xff, sizeof(tcp_demux_slot_of));
+#endif /* UIP_TCP */
+}
+#endif /* UIP_DEMUX_HASH_SIZE */
+/*---------------------------------------------------------------------------*/
 void
 uip_init(void)
 {
@@ -433,6 +526,10 @@ uip_init(void)
   }
 #endif /* UIP_UDP */
 
+#if UIP_DEMUX_HASH_SIZE
+  demux_init();
+#endif /* UIP_DEMUX_HASH_SIZE */
+
 #if UIP_CONF_IPV6_MULTICAST
   UIP_MCAST6.init();
 #endif
@@ -504,6 +601,9 @@ uip_connect(uip_ipaddr_t *ripaddr, uint16_t rport)
   conn->lport = uip_htons(lastport);
   conn->rport = rport;
   uip_ipaddr_copy(&conn->ripaddr, ripaddr);
+#if UIP_DEMUX_HASH_SIZE
+  tcp_rehash(conn);
+#endif /* UIP_DEMUX_HASH_SIZE */
   
   return conn;
 }
@@ -548,11 +648,25 @@ uip_udp_new(const uip_ipaddr_t *ripaddr, uint16_t rport)
     lastport = 4096;
   }
   
+#if UIP_DEMUX_HASH_SIZE
+  {
+    demux_index_t i;
+
+    for(i = udp_demux[udp_demux_slot(uip_htons(lastport))];
+        i != DEMUX_NONE;
+        i = udp_demux_next[i]) {
+      if(uip_udp_conns[i].lport == uip_htons(lastport)) {
+        goto again;
+      }
+    }
+  }
+#else /* UIP_DEMUX_HASH_SIZE */
   for(c = 0; c < UIP_UDP_CONNS; ++c) {
     if(uip_udp_conns[c].lport == uip_htons(lastport)) {
       goto again;
     }
   }
+#endif /* UIP_DEMUX_HASH_SIZE */
 
   conn = 0;
   for(c = 0; c < UIP_UDP_CONNS; ++c) {
@@ -567,6 +681,9 @@ uip_udp_new(const uip_ipaddr_t *ripaddr, uint16_t rport)
   }
   
   conn->lport = UIP_HTONS(lastport);
+#if UIP_DEMUX_HASH_SIZE
+  uip_udp_rehash(conn);
+#endif /* UIP_DEMUX_HASH_SIZE */
   conn->rport = rport;
   if(ripaddr == NULL) {
     memset(&conn->ripaddr, 0, sizeof(uip_ipaddr_t));
@@ -1485,6 +1602,24 @@ uip_process(uint8_t flag)
   }
 
   /* Demultiplex this UDP packet between the UDP "connections". */
+#if UIP_DEMUX_HASH_SIZE
+  {
+    demux_index_t i;
+
+    for(i = udp_demux[udp_demux_slot(UIP_UDP_BUF->destport)];
+        i != DEMUX_NONE;
+        i = udp_demux_next[i]) {
+      uip_udp_conn = &uip_udp_conns[i];
+      if(UIP_UDP_BUF->destport == uip_udp_conn->lport &&
+         (uip_udp_conn->rport == 0 ||
+          UIP_UDP_BUF->srcport == uip_udp_conn->rport) &&
+         (uip_is_addr_unspecified(&uip_udp_conn->ripaddr) ||
+          uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &uip_udp_conn->ripaddr))) {
+        goto udp_found;
+      }
+    }
+  }
+#else /* UIP_DEMUX_HASH_SIZE */
   for(uip_udp_conn = &uip_udp_conns[0];
       uip_udp_conn < &uip_udp_conns[UIP_UDP_CONNS];
       ++uip_udp_conn) {
@@ -1504,6 +1639,7 @@ uip_process(uint8_t flag)
       goto udp_found;
     }
   }
+#endif /* UIP_DEMUX_HASH_SIZE */
   PRINTF("udp: no matching connection found\n");
   UIP_STAT(++uip_stat.udp.drop);
 
@@ -1594,6 +1730,25 @@ uip_process(uint8_t flag)
 
   /* Demultiplex this segment. */
   /* First check any active connections. */
+#if UIP_DEMUX_HASH_SIZE
+  {
+    demux_index_t i;
+
+    for(i = tcp_demux[tcp_demux_slot(UIP_TCP_BUF->destport,
+                                     UIP_TCP_BUF->srcport,
+                                     &UIP_IP_BUF->srcipaddr)];
+        i != DEMUX_NONE;
+        i = tcp_demux_next[i]) {
+      uip_connr = &uip_conns[i];
+      if(uip_connr->tcpstateflags != UIP_CLOSED &&
+         UIP_TCP_BUF->destport == uip_connr->lport &&
+         UIP_TCP_BUF->srcport == uip_connr->rport &&
+         uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &uip_connr->ripaddr)) {
+        goto found;
+      }
+    }
+  }
+#else /* UIP_DEMUX_HASH_SIZE */
   for(uip_connr = &uip_conns[0]; uip_connr <= &uip_conns[UIP_CONNS - 1];
       ++uip_connr) {
     if(uip_connr->tcpstateflags != UIP_CLOSED &&
@@ -1603,6 +1758,7 @@ uip_process(uint8_t flag)
       goto found;
     }
   }
+#endif /* UIP_DEMUX_HASH_SIZE */
 
   /* If we didn't find and active connection that expected the packet,
      either this packet is an old duplicate, or this is a SYN packet
@@ -1718,6 +1874,9 @@ uip_process(uint8_t flag)
   uip_connr->lport = UIP_TCP_BUF->destport;
   uip_connr->rport = UIP_TCP_BUF->srcport;
   uip_ipaddr_copy(&uip_connr->ripaddr, &UIP_IP_BUF->srcipaddr);
+#if UIP_DEMUX_HASH_SIZE
+  tcp_rehash(uip_connr);
+#endif /* UIP_DEMUX_HASH_SIZE */
   uip_connr->tcpstateflags = UIP_SYN_RCVD;
 
   uip_connr->snd_nxt[0] = iss[0];
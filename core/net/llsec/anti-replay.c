@@ -33,7 +33,8 @@
 /**
  * \file
  *         Protects against replay attacks by comparing with the last
- *         unicast or broadcast frame counter of the sender.
+ *         unicast or broadcast frame counter of the sender, and
+ *         optionally with a window of recently received frame counters.
  * \author
  *         Konrad Krentz <konrad.krentz@gmail.com>
  */
@@ -78,8 +79,58 @@ anti_replay_init_info(struct anti_replay_info *info)
   info->last_broadcast_counter
       = info->last_unicast_counter
       = anti_replay_get_counter();
+#if ANTI_REPLAY_WINDOW
+  info->broadcast_window = info->unicast_window = 0;
+#endif /* ANTI_REPLAY_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
+#if ANTI_REPLAY_WINDOW
+static int
+was_replayed(uint32_t *last_counter,
+    anti_replay_window_t *window,
+    uint32_t received_counter)
+{
+  uint32_t diff;
+  anti_replay_window_t bit;
+  
+  if(received_counter > *last_counter) {
+    /* slide the window forward */
+    diff = received_counter - *last_counter;
+    if(diff >= ANTI_REPLAY_WINDOW) {
+      *window = 0;
+    } else {
+      *window <<= diff;
+    }
+    if(diff <= ANTI_REPLAY_WINDOW) {
+      *window |= (anti_replay_window_t)1 << (diff - 1);
+    }
+    *last_counter = received_counter;
+    return 0;
+  }
+  
+  diff = *last_counter - received_counter;
+  if(diff == 0 || diff > ANTI_REPLAY_WINDOW) {
+    return 1;
+  }
+  bit = (anti_replay_window_t)1 << (diff - 1);
+  if(*window & bit) {
+    return 1;
+  }
+  *window |= bit;
+  return 0;
+}
+#else /* ANTI_REPLAY_WINDOW */
+static int
+was_replayed(uint32_t *last_counter, uint32_t received_counter)
+{
+  if(received_counter <= *last_counter) {
+    return 1;
+  }
+  *last_counter = received_counter;
+  return 0;
+}
+#endif /* ANTI_REPLAY_WINDOW */
+/*---------------------------------------------------------------------------*/
 int
 anti_replay_was_replayed(struct anti_replay_info *info)
 {
@@ -87,23 +138,21 @@ anti_replay_was_replayed(struct anti_replay_info *info)
   
   received_counter = anti_replay_get_counter();
   
+#if ANTI_REPLAY_WINDOW
   if(packetbuf_holds_broadcast()) {
-    /* broadcast */
-    if(received_counter <= info->last_broadcast_counter) {
-      return 1;
-    } else {
-      info->last_broadcast_counter = received_counter;
-      return 0;
-    }
+    return was_replayed(&info->last_broadcast_counter,
+        &info->broadcast_window, received_counter);
   } else {
-    /* unicast */
-    if(received_counter <= info->last_unicast_counter) {
-      return 1;
-    } else {
-      info->last_unicast_counter = received_counter;
-      return 0;
-    }
+    return was_replayed(&info->last_unicast_counter,
+        &info->unicast_window, received_counter);
+  }
+#else /* ANTI_REPLAY_WINDOW */
+  if(packetbuf_holds_broadcast()) {
+    return was_replayed(&info->last_broadcast_counter, received_counter);
+  } else {
+    return was_replayed(&info->last_unicast_counter, received_counter);
   }
+#endif /* ANTI_REPLAY_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
 
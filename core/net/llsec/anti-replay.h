@@ -47,9 +47,39 @@
 
 #include "contiki.h"
 
+/*
+ * With ANTI_REPLAY_CONF_WINDOW, frames that arrive out of order, e.g.
+ * due to retransmissions or forwarding along different paths, are
+ * accepted once as long as their frame counter is at most
+ * ANTI_REPLAY_WINDOW below the highest frame counter received from
+ * the sender. A bitmap per sender remembers which of these frame
+ * counters were already received. With the default of 0, frames are
+ * only accepted in strictly increasing order.
+ */
+#ifdef ANTI_REPLAY_CONF_WINDOW
+#define ANTI_REPLAY_WINDOW ANTI_REPLAY_CONF_WINDOW
+#else /* ANTI_REPLAY_CONF_WINDOW */
+#define ANTI_REPLAY_WINDOW 0
+#endif /* ANTI_REPLAY_CONF_WINDOW */
+
+#if ANTI_REPLAY_WINDOW > 32
+#error "ANTI_REPLAY_CONF_WINDOW cannot be greater than 32"
+#elif ANTI_REPLAY_WINDOW > 16
+typedef uint32_t anti_replay_window_t;
+#elif ANTI_REPLAY_WINDOW > 8
+typedef uint16_t anti_replay_window_t;
+#else
+typedef uint8_t anti_replay_window_t;
+#endif
+
 struct anti_replay_info {
   uint32_t last_broadcast_counter;
   uint32_t last_unicast_counter;
+#if ANTI_REPLAY_WINDOW
+  /* bit i is set if last_*_counter - 1 - i was received */
+  anti_replay_window_t broadcast_window;
+  anti_replay_window_t unicast_window;
+#endif /* ANTI_REPLAY_WINDOW */
 };
 
 /**
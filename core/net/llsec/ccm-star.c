@@ -69,9 +69,10 @@ set_nonce(uint8_t *nonce,
   nonce[15] = counter;
 }
 /*---------------------------------------------------------------------------*/
-/* XORs the block m[pos] ... m[pos + 15] with K_{counter} */
+/* XORs the block m[pos] ... m[pos + 15] with K_{counter}, where nonce is
+   the encryption nonce set by set_nonce() */
 static void
-ctr_step(const uint8_t *extended_source_address,
+ctr_step(uint8_t *nonce,
     uint8_t pos,
     uint8_t *m_and_result,
     uint8_t m_len,
@@ -80,7 +81,8 @@ ctr_step(const uint8_t *extended_source_address,
   uint8_t a[AES_128_BLOCK_SIZE];
   uint8_t i;
   
-  set_nonce(a, CCM_STAR_ENCRYPTION_FLAGS, extended_source_address, counter);
+  nonce[15] = counter;
+  memcpy(a, nonce, AES_128_BLOCK_SIZE);
   AES_128.encrypt(a);
   
   for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
@@ -88,40 +90,34 @@ ctr_step(const uint8_t *extended_source_address,
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Adds the block m[pos] ... m[pos + 15] to the CBC-MAC x */
 static void
-mic(const uint8_t *extended_source_address,
-    uint8_t *result,
-    uint8_t mic_len)
+mic_step(uint8_t *x, const uint8_t *m, uint8_t pos, uint8_t m_len)
+{
+  uint8_t i;
+  
+  for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
+    x[i] ^= m[pos + i];
+  }
+  AES_128.encrypt(x);
+}
+/*---------------------------------------------------------------------------*/
+/* Starts the CBC-MAC x over B_0 and the a_len bytes of the header */
+static void
+mic_start(uint8_t *x,
+    const uint8_t *extended_source_address,
+    uint8_t mic_len,
+    uint8_t a_len,
+    uint8_t m_len)
 {
-  uint8_t x[AES_128_BLOCK_SIZE];
   uint8_t pos;
   uint8_t i;
-  uint8_t a_len;
   uint8_t *a;
-#if LLSEC802154_USES_ENCRYPTION
-  uint8_t shall_encrypt;
-  uint8_t m_len;
-  uint8_t *m;
   
-  shall_encrypt = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL) & (1 << 2);
-  if(shall_encrypt) {
-    a_len = packetbuf_hdrlen();
-    m_len = packetbuf_datalen();
-  } else {
-    a_len = packetbuf_totlen();
-    m_len = 0;
-  }
   set_nonce(x,
       CCM_STAR_AUTH_FLAGS(a_len, mic_len),
       extended_source_address,
       m_len);
-#else /* LLSEC802154_USES_ENCRYPTION */
-  a_len = packetbuf_totlen();
-  set_nonce(x,
-      CCM_STAR_AUTH_FLAGS(a_len, mic_len),
-      extended_source_address,
-      0);
-#endif /* LLSEC802154_USES_ENCRYPTION */
   AES_128.encrypt(x);
   
   a = packetbuf_hdrptr();
@@ -133,38 +129,63 @@ mic(const uint8_t *extended_source_address,
     
     AES_128.encrypt(x);
     
-    pos = 14;
-    while(pos < a_len) {
-      for(i = 0; (pos + i < a_len) && (i < AES_128_BLOCK_SIZE); i++) {
-        x[i] ^= a[pos + i];
-      }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
+    for(pos = 14; pos < a_len; pos += AES_128_BLOCK_SIZE) {
+      mic_step(x, a, pos, a_len);
     }
   }
+}
+/*---------------------------------------------------------------------------*/
+/* Encrypts the CBC-MAC x with K_0 and copies it to result */
+static void
+mic_finish(uint8_t *x,
+    uint8_t *nonce,
+    uint8_t *result,
+    uint8_t mic_len)
+{
+  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
   
+  memcpy(result, x, mic_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+mic(const uint8_t *extended_source_address,
+    uint8_t *result,
+    uint8_t mic_len)
+{
+  uint8_t x[AES_128_BLOCK_SIZE];
+  uint8_t nonce[AES_128_BLOCK_SIZE];
+  uint8_t a_len;
 #if LLSEC802154_USES_ENCRYPTION
-  if(shall_encrypt) {
-    m = a + a_len;
-    pos = 0;
-    while(pos < m_len) {
-      for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-        x[i] ^= m[pos + i];
-      }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
-    }
+  uint8_t pos;
+  uint8_t m_len;
+  uint8_t *m;
+  
+  if(packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL) & (1 << 2)) {
+    a_len = packetbuf_hdrlen();
+    m_len = packetbuf_datalen();
+  } else {
+    a_len = packetbuf_totlen();
+    m_len = 0;
   }
-#endif /* LLSEC802154_USES_ENCRYPTION */
+  mic_start(x, extended_source_address, mic_len, a_len, m_len);
   
-  ctr_step(extended_source_address, 0, x, AES_128_BLOCK_SIZE, 0);
+  m = (uint8_t *) packetbuf_hdrptr() + a_len;
+  for(pos = 0; pos < m_len; pos += AES_128_BLOCK_SIZE) {
+    mic_step(x, m, pos, m_len);
+  }
+#else /* LLSEC802154_USES_ENCRYPTION */
+  a_len = packetbuf_totlen();
+  mic_start(x, extended_source_address, mic_len, a_len, 0);
+#endif /* LLSEC802154_USES_ENCRYPTION */
   
-  memcpy(result, x, mic_len);
+  set_nonce(nonce, CCM_STAR_ENCRYPTION_FLAGS, extended_source_address, 0);
+  mic_finish(x, nonce, result, mic_len);
 }
 /*---------------------------------------------------------------------------*/
 static void
 ctr(const uint8_t *extended_source_address)
 {
+  uint8_t nonce[AES_128_BLOCK_SIZE];
   uint8_t m_len;
   uint8_t *m;
   uint8_t pos;
@@ -173,17 +194,62 @@ ctr(const uint8_t *extended_source_address)
   m_len = packetbuf_datalen();
   m = (uint8_t *) packetbuf_dataptr();
   
+  set_nonce(nonce, CCM_STAR_ENCRYPTION_FLAGS, extended_source_address, 0);
   pos = 0;
   counter = 1;
   while(pos < m_len) {
-    ctr_step(extended_source_address, pos, m, m_len, counter++);
+    ctr_step(nonce, pos, m, m_len, counter++);
     pos += AES_128_BLOCK_SIZE;
   }
 }
 /*---------------------------------------------------------------------------*/
+static void
+aead(const uint8_t *extended_source_address,
+    uint8_t *result,
+    uint8_t mic_len,
+    int forward)
+{
+#if LLSEC802154_USES_ENCRYPTION
+  uint8_t x[AES_128_BLOCK_SIZE];
+  uint8_t nonce[AES_128_BLOCK_SIZE];
+  uint8_t m_len;
+  uint8_t *m;
+  uint8_t pos;
+  uint8_t counter;
+  
+  if(!(packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL) & (1 << 2))) {
+    mic(extended_source_address, result, mic_len);
+    return;
+  }
+  
+  m_len = packetbuf_datalen();
+  m = (uint8_t *) packetbuf_dataptr();
+  mic_start(x, extended_source_address, mic_len, packetbuf_hdrlen(), m_len);
+  
+  /* The MIC is over the plaintext, so it is updated before a block is
+     encrypted and after a block is decrypted */
+  set_nonce(nonce, CCM_STAR_ENCRYPTION_FLAGS, extended_source_address, 0);
+  counter = 1;
+  for(pos = 0; pos < m_len; pos += AES_128_BLOCK_SIZE) {
+    if(forward) {
+      mic_step(x, m, pos, m_len);
+      ctr_step(nonce, pos, m, m_len, counter++);
+    } else {
+      ctr_step(nonce, pos, m, m_len, counter++);
+      mic_step(x, m, pos, m_len);
+    }
+  }
+  
+  mic_finish(x, nonce, result, mic_len);
+#else /* LLSEC802154_USES_ENCRYPTION */
+  mic(extended_source_address, result, mic_len);
+#endif /* LLSEC802154_USES_ENCRYPTION */
+}
+/*---------------------------------------------------------------------------*/
 const struct ccm_star_driver ccm_star_driver = {
   mic,
-  ctr
+  ctr,
+  aead
 };
 /*---------------------------------------------------------------------------*/
 
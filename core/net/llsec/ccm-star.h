@@ -76,6 +76,24 @@ struct ccm_star_driver {
    * \brief XORs the frame in the packetbuf with the key stream.
    */
   void (* ctr)(const uint8_t *extended_source_address);
+  
+  /**
+   * \brief         Generates a MIC over the frame in the packetbuf and, if
+   *                the security level requires it, encrypts or decrypts
+   *                the frame in the same pass.
+   * \param result  The generated MIC will be put here
+   * \param mic_len  <= 16; set to LLSEC802154_MIC_LENGTH to be compliant
+   * \param forward Non-zero to encrypt an outgoing frame, zero to
+   *                decrypt an incoming frame
+   *
+   *                Equivalent to mic() followed by ctr() for outgoing
+   *                frames, and to ctr() followed by mic() for incoming
+   *                frames, with the same key.
+   */
+  void (* aead)(const uint8_t *extended_source_address,
+      uint8_t *result,
+      uint8_t mic_len,
+      int forward);
 };
 
 extern const struct ccm_star_driver CCM_STAR;
@@ -116,12 +116,7 @@ coresec_decrypt_verify_unicast(uint8_t *key)
   
   packetbuf_set_datalen(packetbuf_datalen() - CORESEC_UNICAST_MIC_LENGTH);
   CORESEC_SET_PAIRWISE_KEY(key);
-#if LLSEC802154_USES_ENCRYPTION
-  if(sec_lvl & (1 << 2)) {
-    CCM_STAR.ctr(sender_addr);
-  }
-#endif /* LLSEC802154_USES_ENCRYPTION */
-  CCM_STAR.mic(sender_addr, generated_mic, CORESEC_UNICAST_MIC_LENGTH);
+  CCM_STAR.aead(sender_addr, generated_mic, CORESEC_UNICAST_MIC_LENGTH, 0);
   
   received_mic = ((uint8_t *) packetbuf_dataptr()) + packetbuf_datalen();
   return (memcmp(generated_mic, received_mic, CORESEC_UNICAST_MIC_LENGTH) == 0);
@@ -189,16 +184,14 @@ on_frame_created(void)
       return 0;
     }
     
+    if(packetbuf_tailroom() < CORESEC_UNICAST_MIC_LENGTH) {
+      return 0;
+    }
     dataptr = packetbuf_dataptr();
     datalen = packetbuf_datalen();
     
     CORESEC_SET_PAIRWISE_KEY(key);
-    CCM_STAR.mic(linkaddr_node_addr.u8, dataptr + datalen, CORESEC_UNICAST_MIC_LENGTH);
-#if LLSEC802154_USES_ENCRYPTION
-    if(sec_lvl & (1 << 2)) {
-      CCM_STAR.ctr(linkaddr_node_addr.u8);
-    }
-#endif /* LLSEC802154_USES_ENCRYPTION */
+    CCM_STAR.aead(linkaddr_node_addr.u8, dataptr + datalen, CORESEC_UNICAST_MIC_LENGTH, 1);
     packetbuf_set_datalen(datalen + CORESEC_UNICAST_MIC_LENGTH);
   }
   return 1;
@@ -98,6 +98,16 @@ struct neighbor_queue {
   struct ctimer transmit_timer;
   uint8_t transmissions;
   uint8_t collisions, deferrals;
+#if CSMA_FAIR_QUEUEING
+  /* The next queue in the same bucket of the hash index */
+  struct neighbor_queue *hash_next;
+  /* The next queue waiting for its turn to transmit */
+  struct neighbor_queue *ready_next;
+  uint8_t ready;
+  /* Deficit round robin credit, in bytes */
+  uint16_t deficit;
+  struct csma_neighbor_stats stats;
+#endif /* CSMA_FAIR_QUEUEING */
   LIST_STRUCT(queued_packet_list);
 };
 
@@ -121,13 +131,167 @@ MEMB(packet_memb, struct rdc_buf_list, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
 LIST(neighbor_list);
 
+#if CSMA_FAIR_QUEUEING
+/* The number of buckets of the hash index of neighbor queues */
+#ifdef CSMA_CONF_NEIGHBOR_HASH_SIZE
+#define CSMA_NEIGHBOR_HASH_SIZE CSMA_CONF_NEIGHBOR_HASH_SIZE
+#else
+#define CSMA_NEIGHBOR_HASH_SIZE 16
+#endif /* CSMA_CONF_NEIGHBOR_HASH_SIZE */
+
+#if (CSMA_NEIGHBOR_HASH_SIZE & (CSMA_NEIGHBOR_HASH_SIZE - 1)) != 0
+#error CSMA_CONF_NEIGHBOR_HASH_SIZE must be a power of two
+#endif
+
+/* The number of bytes a neighbor queue may send per scheduling round */
+#ifdef CSMA_CONF_DRR_QUANTUM
+#define CSMA_DRR_QUANTUM CSMA_CONF_DRR_QUANTUM
+#else
+#define CSMA_DRR_QUANTUM PACKETBUF_SIZE
+#endif /* CSMA_CONF_DRR_QUANTUM */
+
+#if CSMA_DRR_QUANTUM < 1
+#error CSMA_CONF_DRR_QUANTUM must be at least 1
+#endif
+
+static struct neighbor_queue *neighbor_hash[CSMA_NEIGHBOR_HASH_SIZE];
+
+/* Queues whose transmit timer has expired, in round robin order */
+static struct neighbor_queue *ready_head, *ready_tail;
+static struct ctimer schedule_timer;
+
+/* The queue being handed to the RDC layer, which must not lose packets
+   while the RDC layer may still be walking its list */
+static struct neighbor_queue *transmitting;
+
+/* A packet pushed out of its queue, to be reported to its sender once
+   the packet being queued has been dealt with */
+struct pushed_out {
+  struct pushed_out *next;
+  mac_callback_t sent;
+  void *cptr;
+  linkaddr_t addr;
+};
+MEMB(pushed_out_memb, struct pushed_out, MAX_QUEUED_PACKETS);
+LIST(pushed_out_list);
+static struct ctimer pushed_out_timer;
+
+#define NEIGHBOR_QUEUE_LENGTH(n) ((n)->stats.queued)
+#else /* CSMA_FAIR_QUEUEING */
+#define NEIGHBOR_QUEUE_LENGTH(n) list_length((n)->queued_packet_list)
+#endif /* CSMA_FAIR_QUEUEING */
+
 static void packet_sent(void *ptr, int status, int num_transmissions);
 static void transmit_packet_list(void *ptr);
 
+/*---------------------------------------------------------------------------*/
+#if CSMA_FAIR_QUEUEING
+static struct neighbor_queue **
+hash_bucket(const linkaddr_t *addr)
+{
+  unsigned h = 0;
+  int i;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h * 33) ^ addr->u8[i];
+  }
+  return &neighbor_hash[(h ^ (h >> 5)) & (CSMA_NEIGHBOR_HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(struct neighbor_queue *n)
+{
+  struct neighbor_queue **p;
+  for(p = hash_bucket(&n->addr); *p != NULL; p = &(*p)->hash_next) {
+    if(*p == n) {
+      *p = n->hash_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+ready_add(struct neighbor_queue *n)
+{
+  if(!n->ready) {
+    n->ready = 1;
+    n->ready_next = NULL;
+    if(ready_tail != NULL) {
+      ready_tail->ready_next = n;
+    } else {
+      ready_head = n;
+    }
+    ready_tail = n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct neighbor_queue *
+ready_pop(void)
+{
+  struct neighbor_queue *n = ready_head;
+  if(n != NULL) {
+    ready_head = n->ready_next;
+    if(ready_head == NULL) {
+      ready_tail = NULL;
+    }
+    n->ready = 0;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* Deficit round robin over the queues that are ready to transmit. Each
+   queue gets CSMA_DRR_QUANTUM bytes of credit per round and transmits
+   its first packet once it has enough credit for it, so that a queue
+   with many or long retransmissions gets no more than its share. */
+static void
+schedule_next(void *ptr)
+{
+  struct neighbor_queue *n;
+  struct rdc_buf_list *q;
+  int len;
+
+  while((n = ready_pop()) != NULL) {
+    q = list_head(n->queued_packet_list);
+    if(q == NULL) {
+      n->deficit = 0;
+      continue;
+    }
+    len = queuebuf_datalen(q->buf);
+    if(n->deficit >= len) {
+      n->deficit -= len;
+      transmit_packet_list(n);
+      break;
+    }
+    /* Not enough credit this round: top up and wait for the next */
+    n->deficit += CSMA_DRR_QUANTUM;
+    ready_add(n);
+  }
+
+  if(ready_head != NULL) {
+    /* Let other processes run before the next transmission */
+    ctimer_set(&schedule_timer, 0, schedule_next, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+neighbor_ready(void *ptr)
+{
+  ready_add(ptr);
+  ctimer_set(&schedule_timer, 0, schedule_next, NULL);
+}
+#endif /* CSMA_FAIR_QUEUEING */
 /*---------------------------------------------------------------------------*/
 static struct neighbor_queue *
 neighbor_queue_from_addr(const linkaddr_t *addr)
 {
+#if CSMA_FAIR_QUEUEING
+  struct neighbor_queue *n = *hash_bucket(addr);
+  while(n != NULL) {
+    if(linkaddr_cmp(&n->addr, addr)) {
+      return n;
+    }
+    n = n->hash_next;
+  }
+#else /* CSMA_FAIR_QUEUEING */
   struct neighbor_queue *n = list_head(neighbor_list);
   while(n != NULL) {
     if(linkaddr_cmp(&n->addr, addr)) {
@@ -135,9 +299,21 @@ neighbor_queue_from_addr(const linkaddr_t *addr)
     }
     n = list_item_next(n);
   }
+#endif /* CSMA_FAIR_QUEUEING */
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Set the time of the next transmission from a neighbor queue */
+static void
+schedule_transmission(struct neighbor_queue *n, clock_time_t time)
+{
+#if CSMA_FAIR_QUEUEING
+  ctimer_set(&n->transmit_timer, time, neighbor_ready, n);
+#else /* CSMA_FAIR_QUEUEING */
+  ctimer_set(&n->transmit_timer, time, transmit_packet_list, n);
+#endif /* CSMA_FAIR_QUEUEING */
+}
+/*---------------------------------------------------------------------------*/
 static clock_time_t
 default_timebase(void)
 {
@@ -165,7 +341,13 @@ transmit_packet_list(void *ptr)
       PRINTF("csma: preparing number %d %p, queue len %d\n", n->transmissions, q,
           list_length(n->queued_packet_list));
       /* Send packets in the neighbor's list */
+#if CSMA_FAIR_QUEUEING
+      transmitting = n;
       NETSTACK_RDC.send_list(packet_sent, n, q);
+      transmitting = NULL;
+#else /* CSMA_FAIR_QUEUEING */
+      NETSTACK_RDC.send_list(packet_sent, n, q);
+#endif /* CSMA_FAIR_QUEUEING */
     }
   }
 }
@@ -180,24 +362,128 @@ free_packet(struct neighbor_queue *n, struct rdc_buf_list *p)
     queuebuf_free(p->buf);
     memb_free(&metadata_memb, p->ptr);
     memb_free(&packet_memb, p);
+#if CSMA_FAIR_QUEUEING
+    n->stats.queued--;
+#endif /* CSMA_FAIR_QUEUEING */
     PRINTF("csma: free_queued_packet, queue length %d, free packets %d\n",
            list_length(n->queued_packet_list), memb_numfree(&packet_memb));
+    /* We reset current tx information */
+    n->transmissions = 0;
+    n->collisions = 0;
+    n->deferrals = 0;
     if(list_head(n->queued_packet_list) != NULL) {
-      /* There is a next packet. We reset current tx information */
-      n->transmissions = 0;
-      n->collisions = 0;
-      n->deferrals = 0;
-      /* Set a timer for next transmissions */
-      ctimer_set(&n->transmit_timer, default_timebase(),
-                 transmit_packet_list, n);
+      /* There is a next packet. Set a timer for next transmissions */
+      schedule_transmission(n, default_timebase());
     } else {
-      /* This was the last packet in the queue, we free the neighbor */
+      /* This was the last packet in the queue */
       ctimer_stop(&n->transmit_timer);
+#if CSMA_FAIR_QUEUEING
+      /* Keep the empty queue, and its statistics, until the entry is
+         needed for another neighbor */
+      n->deficit = 0;
+#else /* CSMA_FAIR_QUEUEING */
+      /* We free the neighbor */
       list_remove(neighbor_list, n);
       memb_free(&neighbor_memb, n);
+#endif /* CSMA_FAIR_QUEUEING */
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if CSMA_FAIR_QUEUEING
+/* Get a neighbor queue entry, reusing the entry of an idle neighbor if
+   all are in use */
+static struct neighbor_queue *
+neighbor_queue_alloc(void)
+{
+  struct neighbor_queue *n;
+
+  n = memb_alloc(&neighbor_memb);
+  if(n == NULL) {
+    for(n = list_head(neighbor_list); n != NULL; n = list_item_next(n)) {
+      if(list_head(n->queued_packet_list) == NULL && !n->ready) {
+        hash_remove(n);
+        list_remove(neighbor_list, n);
+        break;
+      }
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* Report the packets pushed out of their queues as failed. The sent
+   callbacks look at the receiver of the packet in packetbuf, so it is
+   set to the neighbor the packet was queued for. */
+static void
+report_pushed_out(void *ptr)
+{
+  struct pushed_out *d;
+  linkaddr_t sender, receiver;
+  mac_callback_t sent;
+  void *cptr;
+
+  linkaddr_copy(&sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  linkaddr_copy(&receiver, packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  while((d = list_pop(pushed_out_list)) != NULL) {
+    packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &d->addr);
+    sent = d->sent;
+    cptr = d->cptr;
+    memb_free(&pushed_out_memb, d);
+    mac_call_sent_callback(sent, cptr, MAC_TX_ERR, 1);
+  }
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &sender);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &receiver);
+}
+/*---------------------------------------------------------------------------*/
+/* Make room for a packet to neighbor n when the packet pool is
+   exhausted, by dropping the last packet of the longest queue if it is
+   longer than that of n. The packetbuf holds the packet for n, so the
+   dropped packet is reported later, by report_pushed_out(). */
+static void
+push_out(struct neighbor_queue *n)
+{
+  struct neighbor_queue *longest, *l;
+  struct rdc_buf_list *q;
+  struct qbuf_metadata *metadata;
+  struct pushed_out *d;
+
+  longest = NULL;
+  for(l = list_head(neighbor_list); l != NULL; l = list_item_next(l)) {
+    if(l != transmitting &&
+       (longest == NULL || l->stats.queued > longest->stats.queued)) {
+      longest = l;
     }
   }
+  if(longest == NULL || longest == n || longest->stats.queued < 2 ||
+     longest->stats.queued <= n->stats.queued + 1) {
+    return;
+  }
+
+  d = memb_alloc(&pushed_out_memb);
+  if(d == NULL) {
+    return;
+  }
+
+  /* The first packet may be on its way to the RDC layer; the last one
+     is not */
+  q = list_chop(longest->queued_packet_list);
+  metadata = (struct qbuf_metadata *)q->ptr;
+  d->sent = metadata->sent;
+  d->cptr = metadata->cptr;
+  linkaddr_copy(&d->addr, &longest->addr);
+  list_add(pushed_out_list, d);
+  ctimer_set(&pushed_out_timer, 0, report_pushed_out, NULL);
+
+  queuebuf_free(q->buf);
+  memb_free(&metadata_memb, q->ptr);
+  memb_free(&packet_memb, q);
+  longest->stats.queued--;
+  longest->stats.dropped++;
+  PRINTF("csma: pushed out a packet, queue length %d\n",
+         longest->stats.queued);
 }
+#endif /* CSMA_FAIR_QUEUEING */
 /*---------------------------------------------------------------------------*/
 static void
 packet_sent(void *ptr, int status, int num_transmissions)
@@ -285,22 +571,34 @@ packet_sent(void *ptr, int status, int num_transmissions)
 
         if(n->transmissions < metadata->max_transmissions) {
           PRINTF("csma: retransmitting with time %lu %p\n", time, q);
-          ctimer_set(&n->transmit_timer, time,
-                     transmit_packet_list, n);
+#if CSMA_FAIR_QUEUEING
+          n->stats.backoffs++;
+          n->stats.backoff_time += time;
+#endif /* CSMA_FAIR_QUEUEING */
+          schedule_transmission(n, time);
           /* This is needed to correctly attribute energy that we spent
              transmitting this packet. */
           queuebuf_update_attr_from_packetbuf(q->buf);
         } else {
           PRINTF("csma: drop with status %d after %d transmissions, %d collisions\n",
                  status, n->transmissions, n->collisions);
+#if CSMA_FAIR_QUEUEING
+          n->stats.failed++;
+#endif /* CSMA_FAIR_QUEUEING */
           free_packet(n, q);
           mac_call_sent_callback(sent, cptr, status, num_tx);
         }
       } else {
         if(status == MAC_TX_OK) {
           PRINTF("csma: rexmit ok %d\n", n->transmissions);
+#if CSMA_FAIR_QUEUEING
+          n->stats.sent++;
+#endif /* CSMA_FAIR_QUEUEING */
         } else {
           PRINTF("csma: rexmit failed %d: %d\n", n->transmissions, status);
+#if CSMA_FAIR_QUEUEING
+          n->stats.failed++;
+#endif /* CSMA_FAIR_QUEUEING */
         }
         free_packet(n, q);
         mac_call_sent_callback(sent, cptr, status, num_tx);
@@ -339,13 +637,24 @@ send_packet(mac_callback_t sent, void *ptr)
   n = neighbor_queue_from_addr(addr);
   if(n == NULL) {
     /* Allocate a new neighbor entry */
+#if CSMA_FAIR_QUEUEING
+    n = neighbor_queue_alloc();
+#else /* CSMA_FAIR_QUEUEING */
     n = memb_alloc(&neighbor_memb);
+#endif /* CSMA_FAIR_QUEUEING */
     if(n != NULL) {
       /* Init neighbor entry */
       linkaddr_copy(&n->addr, addr);
       n->transmissions = 0;
       n->collisions = 0;
       n->deferrals = 0;
+#if CSMA_FAIR_QUEUEING
+      n->ready = 0;
+      n->deficit = 0;
+      memset(&n->stats, 0, sizeof(n->stats));
+      n->hash_next = *hash_bucket(addr);
+      *hash_bucket(addr) = n;
+#endif /* CSMA_FAIR_QUEUEING */
       /* Init packet list for this neighbor */
       LIST_STRUCT_INIT(n, queued_packet_list);
       /* Add neighbor to the list */
@@ -355,7 +664,12 @@ send_packet(mac_callback_t sent, void *ptr)
 
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
-    if(list_length(n->queued_packet_list) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+    if(NEIGHBOR_QUEUE_LENGTH(n) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+#if CSMA_FAIR_QUEUEING
+      if(memb_numfree(&packet_memb) == 0) {
+        push_out(n);
+      }
+#endif /* CSMA_FAIR_QUEUEING */
       q = memb_alloc(&packet_memb);
       if(q != NULL) {
         q->ptr = memb_alloc(&metadata_memb);
@@ -380,12 +694,18 @@ send_packet(mac_callback_t sent, void *ptr)
             } else {
               list_add(n->queued_packet_list, q);
             }
+#if CSMA_FAIR_QUEUEING
+            n->stats.queued++;
+            if(n->stats.queued > n->stats.max_queued) {
+              n->stats.max_queued = n->stats.queued;
+            }
+#endif /* CSMA_FAIR_QUEUEING */
 
             PRINTF("csma: send_packet, queue length %d, free packets %d\n",
                    list_length(n->queued_packet_list), memb_numfree(&packet_memb));
             /* If q is the first packet in the neighbor's queue, send asap */
             if(list_head(n->queued_packet_list) == q) {
-              ctimer_set(&n->transmit_timer, 0, transmit_packet_list, n);
+              schedule_transmission(n, 0);
             }
             return;
           }
@@ -395,14 +715,19 @@ send_packet(mac_callback_t sent, void *ptr)
         memb_free(&packet_memb, q);
         PRINTF("csma: could not allocate queuebuf, dropping packet\n");
       }
+#if !CSMA_FAIR_QUEUEING
       /* The packet allocation failed. Remove and free neighbor entry if empty. */
       if(list_length(n->queued_packet_list) == 0) {
         list_remove(neighbor_list, n);
         memb_free(&neighbor_memb, n);
       }
+#endif /* !CSMA_FAIR_QUEUEING */
     } else {
       PRINTF("csma: Neighbor queue full\n");
     }
+#if CSMA_FAIR_QUEUEING
+    n->stats.dropped++;
+#endif /* CSMA_FAIR_QUEUEING */
     PRINTF("csma: could not allocate packet, dropping packet\n");
   } else {
     PRINTF("csma: could not allocate neighbor, dropping packet\n");
@@ -437,12 +762,27 @@ channel_check_interval(void)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+#if CSMA_FAIR_QUEUEING
+const struct csma_neighbor_stats *
+csma_neighbor_stats(const linkaddr_t *addr)
+{
+  struct neighbor_queue *n = neighbor_queue_from_addr(addr);
+  return n != NULL ? &n->stats : NULL;
+}
+#endif /* CSMA_FAIR_QUEUEING */
+/*---------------------------------------------------------------------------*/
 static void
 init(void)
 {
   memb_init(&packet_memb);
   memb_init(&metadata_memb);
   memb_init(&neighbor_memb);
+#if CSMA_FAIR_QUEUEING
+  memset(neighbor_hash, 0, sizeof(neighbor_hash));
+  ready_head = ready_tail = NULL;
+  memb_init(&pushed_out_memb);
+  list_init(pushed_out_list);
+#endif /* CSMA_FAIR_QUEUEING */
 }
 /*---------------------------------------------------------------------------*/
 const struct mac_driver csma_driver = {
@@ -42,7 +42,50 @@
 #define CSMA_H_
 
 #include "net/mac/mac.h"
+#include "net/linkaddr.h"
 #include "dev/radio.h"
+#include "sys/clock.h"
+
+/* When non-zero, neighbor queues are found through a hash index, take
+   turns to transmit by deficit round robin, and keep per-neighbor
+   statistics. Empty queues are then kept until their entry is needed
+   for another neighbor, and when the packet pool is exhausted the
+   longest queue gives up its last packet to a shorter one. */
+#ifdef CSMA_CONF_FAIR_QUEUEING
+#define CSMA_FAIR_QUEUEING CSMA_CONF_FAIR_QUEUEING
+#else
+#define CSMA_FAIR_QUEUEING 0
+#endif /* CSMA_CONF_FAIR_QUEUEING */
+
+#if CSMA_FAIR_QUEUEING
+/**
+ * Per-neighbor queue statistics, kept while the neighbor has a queue.
+ */
+struct csma_neighbor_stats {
+  /** The number of packets in the queue. */
+  uint16_t queued;
+  /** The largest number of packets that have been in the queue. */
+  uint16_t max_queued;
+  /** The number of packets sent successfully. */
+  unsigned long sent;
+  /** The number of packets given up after their last transmission. */
+  unsigned long failed;
+  /** The number of packets dropped without being sent because the
+      queue or the packet pool was full. */
+  unsigned long dropped;
+  /** The number of retransmissions scheduled after a backoff. */
+  unsigned long backoffs;
+  /** The total backoff time before retransmissions. */
+  clock_time_t backoff_time;
+};
+
+/**
+ * \brief      Get the queue statistics of a neighbor
+ * \param addr The link-layer address of the neighbor
+ * \return     The statistics, or NULL if the neighbor has no queue
+ */
+const struct csma_neighbor_stats *csma_neighbor_stats(const linkaddr_t *addr);
+#endif /* CSMA_FAIR_QUEUEING */
 
 extern const struct mac_driver csma_driver;
 
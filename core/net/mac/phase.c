@@ -44,16 +44,55 @@
 #include "net/queuebuf.h"
 #include "net/nbr-table.h"
 
+/* With PHASE_CONF_DRIFT_CORRECT, the clock drift between this node and
+   each neighbor is estimated from successive phase updates, and the
+   expected phase is corrected for it. This keeps phases accurate for
+   longer when neighbors are sent to seldom. */
 #if PHASE_CONF_DRIFT_CORRECT
 #define PHASE_DRIFT_CORRECT PHASE_CONF_DRIFT_CORRECT
 #else
 #define PHASE_DRIFT_CORRECT 0
 #endif
 
+/* With PHASE_CONF_PERSISTENT, the drift estimates are saved to a CFS
+   file and restored when a phase is learned again after a reboot. The
+   phases themselves are rtimer timestamps, which are meaningless
+   after a reboot, so they are not saved. */
+#ifdef PHASE_CONF_PERSISTENT
+#define PHASE_PERSISTENT PHASE_CONF_PERSISTENT
+#else
+#define PHASE_PERSISTENT 0
+#endif
+
+#if PHASE_PERSISTENT && !PHASE_DRIFT_CORRECT
+#error "PHASE_CONF_PERSISTENT requires PHASE_CONF_DRIFT_CORRECT"
+#endif
+
+#if PHASE_PERSISTENT
+#include "cfs/cfs.h"
+#endif
+
+/* The drift is estimated in 1/PHASE_DRIFT_SCALE rtimer ticks per cycle,
+   and each new measurement is given a weight of 1/PHASE_DRIFT_WEIGHT.
+   Phase updates closer than PHASE_DRIFT_MIN_CYCLES, where the timing
+   jitter outweighs the drift, or further apart than
+   PHASE_DRIFT_MAX_INTERVAL are not used for the estimate. */
+#define PHASE_DRIFT_SCALE        256
+#define PHASE_DRIFT_WEIGHT       4
+#define PHASE_DRIFT_MIN_CYCLES   16
+#define PHASE_DRIFT_MAX_INTERVAL (CLOCK_SECOND * 60)
+/* Phases older than this are not corrected for drift */
+#define PHASE_DRIFT_MAX_AGE      (CLOCK_SECOND * 60 * 8)
+
 struct phase {
   rtimer_clock_t time;
 #if PHASE_DRIFT_CORRECT
-  rtimer_clock_t drift;
+  /* Time between the two last phase updates, in rtimer and clock
+     ticks, not yet used for the drift estimate */
+  rtimer_clock_t elapsed;
+  clock_time_t elapsed_clock;
+  clock_time_t updated;
+  int16_t drift;
 #endif
   uint8_t noacks;
   struct timer noacks_timer;
@@ -77,6 +116,19 @@ struct phase_queueitem {
 MEMB(queued_packets_memb, struct phase_queueitem, PHASE_QUEUESIZE);
 NBR_TABLE(struct phase, nbr_phase);
 
+#if PHASE_PERSISTENT
+#define PHASE_PERSISTENT_FILE     "phase"
+#define PHASE_PERSISTENT_INTERVAL (CLOCK_SECOND * 60 * 10)
+
+struct phase_record {
+  linkaddr_t addr;
+  int16_t drift;
+};
+
+static struct ctimer save_timer;
+static uint8_t drift_changed;
+#endif /* PHASE_PERSISTENT */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -86,6 +138,139 @@ NBR_TABLE(struct phase, nbr_phase);
 #define PRINTF(...)
 #define PRINTDEBUG(...)
 #endif
+#if PHASE_PERSISTENT
+/*---------------------------------------------------------------------------*/
+static void
+save_drifts(void *ptr)
+{
+  struct phase_record r;
+  struct phase *e;
+  int fd;
+
+  if(drift_changed) {
+    drift_changed = 0;
+    cfs_remove(PHASE_PERSISTENT_FILE);
+    fd = cfs_open(PHASE_PERSISTENT_FILE, CFS_WRITE);
+    if(fd >= 0) {
+      for(e = nbr_table_head(nbr_phase); e != NULL; e = nbr_table_next(nbr_phase, e)) {
+        if(e->drift != 0) {
+          linkaddr_copy(&r.addr, nbr_table_get_lladdr(nbr_phase, e));
+          r.drift = e->drift;
+          if(cfs_write(fd, &r, sizeof(r)) != sizeof(r)) {
+            break;
+          }
+        }
+      }
+      cfs_close(fd);
+    }
+  }
+  ctimer_set(&save_timer, PHASE_PERSISTENT_INTERVAL, save_drifts, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static int16_t
+restore_drift(const linkaddr_t *neighbor)
+{
+  struct phase_record r;
+  int16_t drift;
+  int fd;
+
+  drift = 0;
+  fd = cfs_open(PHASE_PERSISTENT_FILE, CFS_READ);
+  if(fd >= 0) {
+    while(cfs_read(fd, &r, sizeof(r)) == sizeof(r)) {
+      if(linkaddr_cmp(&r.addr, neighbor)) {
+        drift = r.drift;
+        break;
+      }
+    }
+    cfs_close(fd);
+  }
+  return drift;
+}
+#endif /* PHASE_PERSISTENT */
+#if PHASE_DRIFT_CORRECT
+/*---------------------------------------------------------------------------*/
+static uint32_t
+elapsed_cycles(clock_time_t elapsed, rtimer_clock_t cycle_time)
+{
+  uint32_t ticks;
+
+  /* The rtimer may have wrapped around, so long intervals are
+     measured with the clock */
+  ticks = (uint32_t)(elapsed / CLOCK_SECOND) * RTIMER_ARCH_SECOND
+      + (uint32_t)(elapsed % CLOCK_SECOND) * RTIMER_ARCH_SECOND / CLOCK_SECOND;
+  return (ticks + cycle_time / 2) / cycle_time;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_drift(struct phase *e, rtimer_clock_t cycle_time)
+{
+  uint32_t cycles;
+  rtimer_clock_t diff;
+  int32_t offset;
+  int32_t sample;
+
+  if(e->elapsed_clock > PHASE_DRIFT_MAX_INTERVAL) {
+    e->elapsed_clock = 0;
+    return;
+  }
+
+  /* The cycles are counted with the clock, and the rtimer only gives
+     the offset within a cycle. This requires the cycle time to divide
+     the rtimer range, as powers of two do. */
+  cycles = elapsed_cycles(e->elapsed_clock, cycle_time);
+  e->elapsed_clock = 0;
+  if(cycles < PHASE_DRIFT_MIN_CYCLES) {
+    return;
+  }
+
+  /* The phase moved by offset during these cycles */
+  diff = e->elapsed - (rtimer_clock_t)(cycles * cycle_time);
+  if(RTIMER_CLOCK_LT(diff, 0)) {
+    offset = -(int32_t)(rtimer_clock_t)(0 - diff);
+  } else {
+    offset = diff;
+  }
+  if(offset > cycle_time / 4 || offset < -(int32_t)(cycle_time / 4)) {
+    /* too large for drift, the neighbor probably changed its phase */
+    return;
+  }
+  sample = offset * PHASE_DRIFT_SCALE / (int32_t)cycles;
+  if(sample > INT16_MAX || sample < -INT16_MAX) {
+    return;
+  }
+
+  if(e->drift == 0) {
+    e->drift = sample;
+  } else {
+    e->drift += (sample - e->drift) / PHASE_DRIFT_WEIGHT;
+  }
+#if PHASE_PERSISTENT
+  drift_changed = 1;
+#endif /* PHASE_PERSISTENT */
+}
+/*---------------------------------------------------------------------------*/
+static rtimer_clock_t
+correct_drift(struct phase *e, rtimer_clock_t sync, rtimer_clock_t cycle_time)
+{
+  clock_time_t elapsed;
+  uint32_t cycles;
+
+  if(e->elapsed_clock != 0) {
+    update_drift(e, cycle_time);
+  }
+  elapsed = clock_time() - e->updated;
+  if(e->drift != 0 && elapsed <= PHASE_DRIFT_MAX_AGE) {
+    /* Move the phase by the estimated drift since it was recorded */
+    cycles = elapsed_cycles(elapsed, cycle_time);
+    if(cycles > INT16_MAX) {
+      cycles = INT16_MAX;
+    }
+    sync += (int32_t)e->drift * (int32_t)cycles / PHASE_DRIFT_SCALE;
+  }
+  return sync;
+}
+#endif /* PHASE_DRIFT_CORRECT */
 /*---------------------------------------------------------------------------*/
 void
 phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
@@ -98,7 +283,9 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
   if(e != NULL) {
     if(mac_status == MAC_TX_OK) {
 #if PHASE_DRIFT_CORRECT
-      e->drift = time-e->time;
+      e->elapsed = time - e->time;
+      e->elapsed_clock = clock_time() - e->updated;
+      e->updated = clock_time();
 #endif
       e->time = time;
     }
@@ -126,9 +313,15 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
       if(e) {
         e->time = time;
 #if PHASE_DRIFT_CORRECT
-      e->drift = 0;
+        e->elapsed_clock = 0;
+        e->updated = clock_time();
+#if PHASE_PERSISTENT
+        e->drift = restore_drift(neighbor);
+#else /* PHASE_PERSISTENT */
+        e->drift = 0;
+#endif /* PHASE_PERSISTENT */
 #endif
-      e->noacks = 0;
+        e->noacks = 0;
       }
     }
   }
@@ -186,14 +379,7 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
     sync = (e == NULL) ? now : e->time;
 
 #if PHASE_DRIFT_CORRECT
-    {
-      int32_t s;
-      if(e->drift > cycle_time) {
-        s = e->drift % cycle_time / (e->drift / cycle_time);  /* drift per cycle */
-        s = s * (now - sync) / cycle_time;                    /* estimated drift to now */
-        sync += s;                                            /* add it in */
-      }
-    }
+    sync = correct_drift(e, sync, cycle_time);
 #endif
 
     /* Check if cycle_time is a power of two */
@@ -243,5 +429,8 @@ phase_init(void)
 {
   memb_init(&queued_packets_memb);
   nbr_table_register(nbr_phase, NULL);
+#if PHASE_PERSISTENT
+  ctimer_set(&save_timer, PHASE_PERSISTENT_INTERVAL, save_drifts, NULL);
+#endif /* PHASE_PERSISTENT */
 }
 /*---------------------------------------------------------------------------*/
@@ -38,6 +38,7 @@
 #include <string.h>
 #include "lib/memb.h"
 #include "lib/list.h"
+#include "lib/hash-index.h"
 #include "net/nbr-table.h"
 
 /* List of link-layer addresses of the neighbors, used as key in the tables */
@@ -62,6 +63,19 @@ static unsigned num_tables;
 MEMB(neighbor_addr_mem, nbr_table_key_t, NBR_TABLE_MAX_NEIGHBORS);
 LIST(nbr_table_keys);
 
+#if NBR_TABLE_HASH_SIZE
+#if (NBR_TABLE_HASH_SIZE & (NBR_TABLE_HASH_SIZE - 1)) != 0
+#error NBR_TABLE_CONF_HASH_SIZE must be a power of two
+#endif
+#if NBR_TABLE_HASH_SIZE <= NBR_TABLE_MAX_NEIGHBORS
+#error NBR_TABLE_CONF_HASH_SIZE must be larger than NBR_TABLE_MAX_NEIGHBORS
+#endif
+/* Hash index from link-layer address to neighbor. Each slot holds the
+ * neighbor index plus one. */
+static unsigned key_hash(unsigned entry);
+HASH_INDEX(hash_index, NBR_TABLE_MAX_NEIGHBORS, NBR_TABLE_HASH_SIZE, key_hash);
+#endif /* NBR_TABLE_HASH_SIZE */
+
 /*---------------------------------------------------------------------------*/
 /* Get a key from a neighbor index */
 static nbr_table_key_t *
@@ -105,16 +119,50 @@ key_from_item(nbr_table_t *table, const nbr_table_item_t *item)
   return key_from_index(index_from_item(table, item));
 }
 /*---------------------------------------------------------------------------*/
+#if NBR_TABLE_HASH_SIZE
+/* Get the hash of a link-layer address */
+static unsigned
+lladdr_hash(const linkaddr_t *lladdr)
+{
+  unsigned h = 0;
+  int i;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h * 33) ^ lladdr->u8[i];
+  }
+  return h ^ (h >> 7);
+}
+/*---------------------------------------------------------------------------*/
+/* Get the hash of the link-layer address of a neighbor in the hash index */
+static unsigned
+key_hash(unsigned entry)
+{
+  return lladdr_hash(&key_from_index(entry - 1)->lladdr);
+}
+#endif /* NBR_TABLE_HASH_SIZE */
+/*---------------------------------------------------------------------------*/
 /* Get the index of a neighbor from its link-layer address */
 static int
 index_from_lladdr(const linkaddr_t *lladdr)
 {
+#if NBR_TABLE_HASH_SIZE
+  unsigned slot;
+  int index;
+#else /* NBR_TABLE_HASH_SIZE */
   nbr_table_key_t *key;
+#endif /* NBR_TABLE_HASH_SIZE */
   /* Allow lladdr-free insertion, useful e.g. for IPv6 ND.
    * Only one such entry is possible at a time, indexed by linkaddr_null. */
   if(lladdr == NULL) {
     lladdr = &linkaddr_null;
   }
+#if NBR_TABLE_HASH_SIZE
+  for(slot = lladdr_hash(lladdr);
+      (index = hash_index_get(&hash_index, slot)) != 0; slot++) {
+    if(linkaddr_cmp(lladdr, &key_from_index(index - 1)->lladdr)) {
+      return index - 1;
+    }
+  }
+#else /* NBR_TABLE_HASH_SIZE */
   key = list_head(nbr_table_keys);
   while(key != NULL) {
     if(lladdr && linkaddr_cmp(lladdr, &key->lladdr)) {
@@ -122,6 +170,7 @@ index_from_lladdr(const linkaddr_t *lladdr)
     }
     key = list_item_next(key);
   }
+#endif /* NBR_TABLE_HASH_SIZE */
   return -1;
 }
 /*---------------------------------------------------------------------------*/
@@ -218,6 +267,9 @@ nbr_table_allocate(void)
       used_map[index_from_key(least_used_key)] = 0;
       /* Remove neighbor from list */
       list_remove(nbr_table_keys, least_used_key);
+#if NBR_TABLE_HASH_SIZE
+      hash_index_remove(&hash_index, index_from_key(least_used_key) + 1);
+#endif /* NBR_TABLE_HASH_SIZE */
       /* Return associated key */
       return least_used_key;
     }
@@ -298,6 +350,9 @@ nbr_table_add_lladdr(nbr_table_t *table, const linkaddr_t *lladdr)
 
     /* Set link-layer address */
     linkaddr_copy(&key->lladdr, lladdr);
+#if NBR_TABLE_HASH_SIZE
+    hash_index_insert(&hash_index, index_from_key(key) + 1);
+#endif /* NBR_TABLE_HASH_SIZE */
   }
 
   /* Get item in the current table */
@@ -341,6 +396,30 @@ nbr_table_unlock(nbr_table_t *table, void *item)
   return nbr_set_bit(locked_map, table, item, 0);
 }
 /*---------------------------------------------------------------------------*/
+/* Change the link-layer address of a neighbor */
+int
+nbr_table_update_lladdr(nbr_table_t *table, const nbr_table_item_t *item,
+                        const linkaddr_t *lladdr)
+{
+  nbr_table_key_t *key = key_from_item(table, item);
+
+  if(key == NULL) {
+    return 0;
+  }
+  if(lladdr == NULL) {
+    lladdr = &linkaddr_null;
+  }
+#if NBR_TABLE_HASH_SIZE
+  /* The hash index is keyed by the address */
+  hash_index_remove(&hash_index, index_from_key(key) + 1);
+#endif /* NBR_TABLE_HASH_SIZE */
+  linkaddr_copy(&key->lladdr, lladdr);
+#if NBR_TABLE_HASH_SIZE
+  hash_index_insert(&hash_index, index_from_key(key) + 1);
+#endif /* NBR_TABLE_HASH_SIZE */
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 /* Get link-layer address of an item */
 linkaddr_t *
 nbr_table_get_lladdr(nbr_table_t *table, const void *item)
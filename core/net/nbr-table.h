@@ -46,6 +46,17 @@
 #define NBR_TABLE_MAX_NEIGHBORS 8
 #endif /* NBR_TABLE_CONF_MAX_NEIGHBORS */
 
+/* Size of the hash index from link-layer address to neighbor, in
+ * slots. When non-zero, lookups by link-layer address use an open
+ * addressing hash table instead of walking the neighbor list. Must be a
+ * power of two larger than NBR_TABLE_MAX_NEIGHBORS; about twice the
+ * number of neighbors keeps probe sequences short. */
+#ifdef NBR_TABLE_CONF_HASH_SIZE
+#define NBR_TABLE_HASH_SIZE NBR_TABLE_CONF_HASH_SIZE
+#else /* NBR_TABLE_CONF_HASH_SIZE */
+#define NBR_TABLE_HASH_SIZE 0
+#endif /* NBR_TABLE_CONF_HASH_SIZE */
+
 /* An item in a neighbor table */
 typedef void nbr_table_item_t;
 
@@ -98,6 +109,11 @@ int nbr_table_unlock(nbr_table_t *table, nbr_table_item_t *item);
 /** \name Neighbor tables: address manipulation */
 /** @{ */
 linkaddr_t *nbr_table_get_lladdr(nbr_table_t *table, const nbr_table_item_t *item);
+/* Change the link-layer address of a neighbor, in all tables. The
+   address must not be written through nbr_table_get_lladdr(), as the
+   neighbor is also indexed by it. */
+int nbr_table_update_lladdr(nbr_table_t *table, const nbr_table_item_t *item,
+                            const linkaddr_t *lladdr);
 /** @} */
 
 #endif /* NBR_TABLE_H_ */
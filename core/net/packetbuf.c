@@ -55,6 +55,9 @@ struct packetbuf_addr packetbuf_addrs[PACKETBUF_NUM_ADDRS];
 static uint16_t buflen, bufptr;
 static uint8_t hdrptr;
 
+/* Set by packetbuf_mark_data(), cleared when the data may change */
+static uint8_t data_marked;
+
 /* The declarations below ensure that the packet buffer is aligned on
    an even 16-bit boundary. On some platforms (most notably the
    msp430), having apotentially misaligned packet buffer may lead to
@@ -78,6 +81,7 @@ packetbuf_clear(void)
 {
   buflen = bufptr = 0;
   hdrptr = PACKETBUF_HDR_SIZE;
+  data_marked = 0;
 
   packetbufptr = &packetbuf[PACKETBUF_HDR_SIZE];
   packetbuf_attr_clear();
@@ -107,9 +111,11 @@ packetbuf_compact(void)
   int i, len;
 
   if(packetbuf_is_reference()) {
+    data_marked = 0;
     memcpy(&packetbuf[PACKETBUF_HDR_SIZE], packetbuf_reference_ptr(),
 	   packetbuf_datalen());
   } else if(bufptr > 0) {
+    data_marked = 0;
     len = packetbuf_datalen() + PACKETBUF_HDR_SIZE;
     for(i = PACKETBUF_HDR_SIZE; i < len; i++) {
       packetbuf[i] = packetbuf[bufptr + i];
@@ -193,6 +199,7 @@ packetbuf_hdrreduce(int size)
 
   bufptr += size;
   buflen -= size;
+  data_marked = 0;
   return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -201,14 +208,28 @@ packetbuf_set_datalen(uint16_t len)
 {
   PRINTF("packetbuf_set_len: len %d\n", len);
   buflen = len;
+  data_marked = 0;
 }
 /*---------------------------------------------------------------------------*/
 void *
 packetbuf_dataptr(void)
 {
+  data_marked = 0;
   return (void *)(&packetbuf[bufptr + PACKETBUF_HDR_SIZE]);
 }
 /*---------------------------------------------------------------------------*/
+void
+packetbuf_mark_data(void)
+{
+  data_marked = bufptr == 0 && !packetbuf_is_reference();
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_data_is_marked(void)
+{
+  return data_marked;
+}
+/*---------------------------------------------------------------------------*/
 void *
 packetbuf_hdrptr(void)
 {
@@ -262,6 +283,55 @@ packetbuf_totlen(void)
   return packetbuf_hdrlen() + packetbuf_datalen();
 }
 /*---------------------------------------------------------------------------*/
+uint16_t
+packetbuf_headroom(void)
+{
+  uint16_t tailroom;
+
+  tailroom = packetbuf_tailroom();
+  return hdrptr < tailroom ? hdrptr : tailroom;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+packetbuf_tailroom(void)
+{
+  uint16_t totlen;
+
+  /* packetbuf_set_datalen() does not enforce the size limit */
+  totlen = packetbuf_totlen();
+  return totlen < PACKETBUF_SIZE ? PACKETBUF_SIZE - totlen : 0;
+}
+/*---------------------------------------------------------------------------*/
+void *
+packetbuf_span(int index, uint16_t *len)
+{
+  uint8_t *hdr, *data;
+  uint16_t hdrlen, datalen;
+
+  hdr = &packetbuf[hdrptr];
+  hdrlen = PACKETBUF_HDR_SIZE - hdrptr;
+  data = packetbufptr + bufptr;
+  datalen = buflen;
+
+  if(hdr + hdrlen == data) {
+    /* The header and the data are adjacent */
+    data = hdr;
+    datalen += hdrlen;
+  } else if(hdrlen > 0) {
+    if(index == 0) {
+      *len = hdrlen;
+      return hdr;
+    }
+    index--;
+  }
+  if(index == 0 && datalen > 0) {
+    *len = datalen;
+    return data;
+  }
+  *len = 0;
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 void
 packetbuf_attr_clear(void)
 {
@@ -120,6 +120,31 @@ void packetbuf_hdr_remove(int bytes);
  */
 void *packetbuf_dataptr(void);
 
+/**
+ * \brief      Mark the data in the packetbuf as unchanged
+ *
+ *             This function is used by the queuebuf module to
+ *             remember that the data in the packetbuf is a copy of a
+ *             queued packet. The mark is removed by every function
+ *             that changes the data, or that returns a pointer through
+ *             which the data can be changed, such as
+ *             packetbuf_dataptr(). Code that writes the data through
+ *             an old pointer must call one of these functions, such
+ *             as packetbuf_set_datalen(), before the packet is queued.
+ *             The data cannot be marked after packetbuf_hdrreduce(),
+ *             or when the packetbuf references external data.
+ *
+ */
+void packetbuf_mark_data(void);
+
+/**
+ * \brief      Check if the data in the packetbuf is unchanged
+ * \return     Non-zero if the data has not been changed since
+ *             packetbuf_mark_data() was called, zero otherwise
+ *
+ */
+int packetbuf_data_is_marked(void);
+
 /**
  * \brief      Get a pointer to the header in the packetbuf, for outbound packets
  * \return     Pointer to the packetbuf header
@@ -171,6 +196,50 @@ uint16_t packetbuf_datalen(void);
  */
 uint16_t packetbuf_totlen(void);
 
+/**
+ * \brief      Get the number of bytes that can be added to the header
+ * \return     The number of bytes that packetbuf_hdralloc() can allocate
+ *
+ *             For outbound packets, the header is allocated from the
+ *             end of the header space, the size of which is set with
+ *             PACKETBUF_CONF_HDR_SIZE. Layers that prepend headers
+ *             can use this function to check that there is room for
+ *             their header, without moving the data.
+ *
+ */
+uint16_t packetbuf_headroom(void);
+
+/**
+ * \brief      Get the number of bytes that can be added to the data
+ * \return     The number of bytes that the packet can grow by
+ *
+ *             This function returns the number of bytes that can be
+ *             added after the data with packetbuf_set_datalen(), for
+ *             example for a message integrity code, before the packet
+ *             exceeds PACKETBUF_SIZE. It returns zero if the packet
+ *             already exceeds PACKETBUF_SIZE.
+ *
+ */
+uint16_t packetbuf_tailroom(void);
+
+/**
+ * \brief      Get a contiguous part of the packet in the packetbuf
+ * \param index The number of the part, starting from zero
+ * \param len  Pointer to where the length of the part is stored
+ * \return     Pointer to the part, or NULL if there is no such part
+ *
+ *             The packet in the packetbuf consists of the header and
+ *             the data, which can be stored after a gap left by
+ *             packetbuf_hdrreduce(), or be referenced to an external
+ *             location. This function returns the parts of the packet
+ *             in order, where adjacent parts are returned as one, so
+ *             that a packet can be read without first calling
+ *             packetbuf_compact(). A packet that is contiguous in
+ *             memory has one part.
+ *
+ */
+void *packetbuf_span(int index, uint16_t *len);
+
 /**
  * \brief      Set the length of the data in the packetbuf
  * \param len  The length of the data
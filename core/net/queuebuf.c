@@ -75,10 +75,26 @@ struct queuebuf {
 #endif
 };
 
+#if QUEUEBUF_SHARED
+/* Packet data that can be shared by several queuebufs */
+struct queuebuf_payload {
+  uint8_t data[PACKETBUF_SIZE];
+  uint16_t len;
+  uint8_t refcount;
+};
+#endif /* QUEUEBUF_SHARED */
+
 /* The actual queuebuf data */
 struct queuebuf_data {
+#if QUEUEBUF_SHARED
+  /* The packet is the prefix followed by the payload */
+  struct queuebuf_payload *payload;
+  uint8_t prefix[PACKETBUF_HDR_SIZE];
+  uint8_t prefixlen;
+#else /* QUEUEBUF_SHARED */
   uint8_t data[PACKETBUF_SIZE];
   uint16_t len;
+#endif /* QUEUEBUF_SHARED */
   struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
   struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
 };
@@ -94,6 +110,19 @@ MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
 MEMB(refbufmem, struct queuebuf_ref, QUEUEBUF_REF_NUM);
 MEMB(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
 
+#if QUEUEBUF_SHARED
+MEMB(payloadmem, struct queuebuf_payload, QUEUEBUF_NUM);
+
+/* The payload that the packetbuf data ends with, after mirror_offset
+   other bytes, as long as the packetbuf data is marked. The mirror
+   holds a reference to the payload. */
+static struct queuebuf_payload *mirror;
+static uint8_t mirror_offset;
+
+/* Contiguous copy of a packet, returned by queuebuf_dataptr() */
+static uint8_t flatdata[PACKETBUF_SIZE];
+#endif /* QUEUEBUF_SHARED */
+
 #if WITH_SWAP
 
 /* Swapping allows to store up to QUEUEBUF_NUM - QUEUEBUFRAM_NUM
@@ -288,6 +317,112 @@ queuebuf_load_to_ram(struct queuebuf *b)
   return b->ram_ptr;
 }
 #endif /* WITH_SWAP */
+#if QUEUEBUF_SHARED
+/*---------------------------------------------------------------------------*/
+static void
+payload_release(struct queuebuf_payload *p)
+{
+  if(--p->refcount == 0) {
+    memb_free(&payloadmem, p);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+mirror_set(struct queuebuf_payload *p, uint8_t offset)
+{
+  if(p != NULL) {
+    p->refcount++;
+    packetbuf_mark_data();
+  }
+  if(mirror != NULL) {
+    payload_release(mirror);
+  }
+  mirror = p;
+  mirror_offset = offset;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the payload that the packetbuf data ends with, if any */
+static struct queuebuf_payload *
+mirror_get(void)
+{
+  if(mirror != NULL &&
+     (!packetbuf_data_is_marked() ||
+      packetbuf_datalen() != mirror_offset + mirror->len)) {
+    mirror_set(NULL, 0);
+  }
+  return mirror;
+}
+/*---------------------------------------------------------------------------*/
+static struct queuebuf_payload *
+payload_alloc(void)
+{
+  struct queuebuf_payload *p;
+
+  p = memb_alloc(&payloadmem);
+  if(p == NULL && mirror != NULL && mirror->refcount == 1) {
+    /* Take back the payload that only the mirror refers to */
+    mirror_set(NULL, 0);
+    p = memb_alloc(&payloadmem);
+  }
+  if(p != NULL) {
+    p->refcount = 1;
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+/* Stores the packetbuf in d. The payload of the packetbuf is shared if
+   it is mirrored, otherwise it is copied to old, if that is not shared,
+   or to a new payload. */
+static int
+store_packetbuf(struct queuebuf_data *d, struct queuebuf_payload *old)
+{
+  struct queuebuf_payload *p;
+  uint16_t datalen;
+
+  d->prefixlen = packetbuf_copyto_hdr(d->prefix);
+  datalen = packetbuf_datalen();
+  p = mirror_get();
+
+  if(d->prefixlen + datalen > PACKETBUF_SIZE) {
+    /* Too large packet, stored as an empty one like packetbuf_copyto()
+       does */
+    datalen = 0;
+    d->prefixlen = 0;
+  } else if(p != NULL && d->prefixlen + mirror_offset <= PACKETBUF_HDR_SIZE) {
+    memcpy(d->prefix + d->prefixlen, packetbuf_dataptr(), mirror_offset);
+    d->prefixlen += mirror_offset;
+    /* Reading the data did not change it */
+    packetbuf_mark_data();
+    if(p != old) {
+      p->refcount++;
+      if(old != NULL) {
+        payload_release(old);
+      }
+      d->payload = p;
+    }
+    return 1;
+  }
+
+  if(old != NULL && old->refcount == 1) {
+    p = old;
+  } else {
+    p = payload_alloc();
+    if(p == NULL) {
+      return 0;
+    }
+    if(old != NULL) {
+      payload_release(old);
+    }
+  }
+  p->len = datalen;
+  memcpy(p->data, packetbuf_dataptr(), datalen);
+  d->payload = p;
+  if(datalen == packetbuf_datalen()) {
+    mirror_set(p, 0);
+  }
+  return 1;
+}
+#endif /* QUEUEBUF_SHARED */
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_init(void)
@@ -302,6 +437,10 @@ queuebuf_init(void)
   memb_init(&buframmem);
   memb_init(&bufmem);
   memb_init(&refbufmem);
+#if QUEUEBUF_SHARED
+  memb_init(&payloadmem);
+  mirror = NULL;
+#endif /* QUEUEBUF_SHARED */
 #if QUEUEBUF_STATS
   queuebuf_max_len = QUEUEBUF_NUM;
 #endif /* QUEUEBUF_STATS */
@@ -372,7 +511,16 @@ queuebuf_new_from_packetbuf(void)
       buframptr = buf->ram_ptr;
 #endif
 
+#if QUEUEBUF_SHARED
+      if(!store_packetbuf(buframptr, NULL)) {
+        PRINTF("queuebuf_new_from_packetbuf: could not allocate a payload\n");
+        memb_free(&buframmem, buframptr);
+        memb_free(&bufmem, buf);
+        return NULL;
+      }
+#else /* QUEUEBUF_SHARED */
       buframptr->len = packetbuf_copyto(buframptr->data);
+#endif /* QUEUEBUF_SHARED */
       packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
 
 #if WITH_SWAP
@@ -420,7 +568,11 @@ queuebuf_update_from_packetbuf(struct queuebuf *buf)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
+#if QUEUEBUF_SHARED
+  store_packetbuf(buframptr, buframptr->payload);
+#else /* QUEUEBUF_SHARED */
   buframptr->len = packetbuf_copyto(buframptr->data);
+#endif /* QUEUEBUF_SHARED */
 #if WITH_SWAP
   if(buf->location == IN_CFS) {
     queuebuf_flush_tmpdata();
@@ -439,6 +591,9 @@ queuebuf_free(struct queuebuf *buf)
       queuebuf_remove_from_file(buf->swap_id);
     }
 #else
+#if QUEUEBUF_SHARED
+    payload_release(buf->ram_ptr->payload);
+#endif /* QUEUEBUF_SHARED */
     memb_free(&buframmem, buf->ram_ptr);
 #endif
     memb_free(&bufmem, buf);
@@ -463,8 +618,24 @@ queuebuf_to_packetbuf(struct queuebuf *b)
   struct queuebuf_ref *r;
   if(memb_inmemb(&bufmem, b)) {
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
+#if QUEUEBUF_SHARED
+    struct queuebuf_payload *p = buframptr->payload;
+    if(mirror_get() == p && mirror_offset == buframptr->prefixlen) {
+      /* The payload is already in the packetbuf */
+      packetbuf_clear_hdr();
+      memcpy(packetbuf_dataptr(), buframptr->prefix, buframptr->prefixlen);
+    } else {
+      packetbuf_copyfrom(buframptr->prefix, buframptr->prefixlen);
+      memcpy((uint8_t *)packetbuf_dataptr() + buframptr->prefixlen,
+             p->data, p->len);
+      packetbuf_set_datalen(buframptr->prefixlen + p->len);
+    }
+    packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+    mirror_set(p, buframptr->prefixlen);
+#else /* QUEUEBUF_SHARED */
     packetbuf_copyfrom(buframptr->data, buframptr->len);
     packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+#endif /* QUEUEBUF_SHARED */
   } else if(memb_inmemb(&refbufmem, b)) {
     r = (struct queuebuf_ref *)b;
     packetbuf_clear();
@@ -481,7 +652,17 @@ queuebuf_dataptr(struct queuebuf *b)
 
   if(memb_inmemb(&bufmem, b)) {
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
+#if QUEUEBUF_SHARED
+    if(buframptr->prefixlen == 0) {
+      return buframptr->payload->data;
+    }
+    memcpy(flatdata, buframptr->prefix, buframptr->prefixlen);
+    memcpy(flatdata + buframptr->prefixlen, buframptr->payload->data,
+           buframptr->payload->len);
+    return flatdata;
+#else /* QUEUEBUF_SHARED */
     return buframptr->data;
+#endif /* QUEUEBUF_SHARED */
   } else if(memb_inmemb(&refbufmem, b)) {
     r = (struct queuebuf_ref *)b;
     return r->ref;
@@ -493,7 +674,11 @@ int
 queuebuf_datalen(struct queuebuf *b)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
+#if QUEUEBUF_SHARED
+  return buframptr->prefixlen + buframptr->payload->len;
+#else /* QUEUEBUF_SHARED */
   return buframptr->len;
+#endif /* QUEUEBUF_SHARED */
 }
 /*---------------------------------------------------------------------------*/
 linkaddr_t *
@@ -85,6 +85,24 @@
 #define QUEUEBUF_DEBUG 0
 #endif /* QUEUEBUF_CONF_DEBUG */
 
+/* With QUEUEBUF_CONF_SHARED, the packet data of a queuebuf is kept in
+   a reference-counted payload buffer. A queuebuf created from a
+   packetbuf that was itself filled by queuebuf_to_packetbuf() shares
+   the payload of the original queuebuf and only stores its own
+   headers and attributes, and queuebuf_to_packetbuf() does not copy
+   a payload that is already in the packetbuf. This saves the copies
+   made when a packet is passed on through several queues, or sent
+   again from the same queue. Cannot be used with swapping. */
+#ifdef QUEUEBUF_CONF_SHARED
+#define QUEUEBUF_SHARED QUEUEBUF_CONF_SHARED
+#else /* QUEUEBUF_CONF_SHARED */
+#define QUEUEBUF_SHARED 0
+#endif /* QUEUEBUF_CONF_SHARED */
+
+#if QUEUEBUF_SHARED && WITH_SWAP
+#error "QUEUEBUF_CONF_SHARED cannot be used when QUEUEBUFRAM_CONF_NUM < QUEUEBUF_NUM"
+#endif
+
 struct queuebuf;
 
 void queuebuf_init(void);
@@ -101,6 +119,12 @@ void queuebuf_update_from_packetbuf(struct queuebuf *b);
 void queuebuf_to_packetbuf(struct queuebuf *b);
 void queuebuf_free(struct queuebuf *b);
 
+/* The data of a queuebuf is read-only, and the pointer returned by
+   queuebuf_dataptr() is only valid until the next call to a queuebuf
+   function: with swapping or QUEUEBUF_CONF_SHARED it may point to a
+   temporary copy, or to data shared with other queuebufs. To change
+   a queued packet, use queuebuf_to_packetbuf() and
+   queuebuf_update_from_packetbuf(). */
 void *queuebuf_dataptr(struct queuebuf *b);
 int queuebuf_datalen(struct queuebuf *b);
 
@@ -46,7 +46,7 @@
 #include "contiki.h"
 #include "lib/list.h"
 
-LIST(ctimer_list);
+#include <string.h>
 
 static char initialized;
 
@@ -59,6 +59,273 @@ static char initialized;
 #endif
 
 /*---------------------------------------------------------------------------*/
+#if CTIMER_WHEEL_SIZE
+#if (CTIMER_WHEEL_SIZE & (CTIMER_WHEEL_SIZE - 1)) != 0
+#error CTIMER_CONF_WHEEL_SIZE must be a power of two
+#endif
+
+#define WHEEL_MASK (CTIMER_WHEEL_SIZE - 1)
+
+/*
+ * Pending timers are kept on the list of the slot for their expiration
+ * time modulo the wheel size. Each timer points back at the pointer
+ * that points to it, so it can be unlinked without knowing its slot.
+ * The timer's own etimer is not on the etimer list; it only holds the
+ * start time and interval, and its process field tells whether the
+ * timer is pending, so that etimer_expired() and
+ * etimer_expiration_time() keep working on ctimer->etimer.
+ *
+ * wheel_time is the last clock tick whose slot has been processed. Its
+ * slot is processed again on the next run, as timers that expire
+ * immediately are put there. A single etimer, wheel_etimer, is set to
+ * the earliest expiration time.
+ */
+static struct ctimer *wheel[CTIMER_WHEEL_SIZE];
+static clock_time_t wheel_time;
+static struct etimer wheel_etimer;
+static unsigned int wheel_count;
+/* Expired timers whose callbacks have not been called yet */
+static struct ctimer *expired_list;
+
+PROCESS(ctimer_process, "Ctimer process");
+/*---------------------------------------------------------------------------*/
+/* Same definition of expired as timer_expired(), relative to now */
+static clock_time_t
+time_left(struct ctimer *c, clock_time_t now)
+{
+  clock_time_t elapsed = now - c->etimer.timer.start;
+  if(elapsed >= c->etimer.timer.interval) {
+    return 0;
+  }
+  return c->etimer.timer.interval - elapsed;
+}
+/*---------------------------------------------------------------------------*/
+static void
+link_timer(struct ctimer **head, struct ctimer *c)
+{
+  c->next = *head;
+  if(c->next != NULL) {
+    c->next->pprev = &c->next;
+  }
+  c->pprev = head;
+  *head = c;
+}
+/*---------------------------------------------------------------------------*/
+static void
+unlink_timer(struct ctimer *c)
+{
+  struct ctimer **pp;
+
+  /* The links of a timer that was never set may hold anything, so they
+     are only followed once the timer is known to be linked: a pending
+     timer has ctimer_process in its etimer, and an expired one is found
+     on the expired list by comparing pointers only. */
+  if(c->etimer.p == &ctimer_process) {
+    wheel_count--;
+  } else {
+    for(pp = &expired_list; *pp != NULL && *pp != c; pp = &(*pp)->next);
+    if(*pp == NULL) {
+      c->etimer.p = PROCESS_NONE;
+      return;
+    }
+  }
+  *c->pprev = c->next;
+  if(c->next != NULL) {
+    c->next->pprev = c->pprev;
+  }
+  c->pprev = NULL;
+  c->next = NULL;
+  c->etimer.p = PROCESS_NONE;
+}
+/*---------------------------------------------------------------------------*/
+/* Set the wheel etimer to expire after the given number of ticks,
+   unless it already expires earlier */
+static void
+arm_wheel(clock_time_t left, int force)
+{
+  clock_time_t now;
+
+  if(!initialized) {
+    return;
+  }
+  now = clock_time();
+  if(!force && !etimer_expired(&wheel_etimer)) {
+    clock_time_t elapsed = now - etimer_start_time(&wheel_etimer);
+    if(elapsed >= wheel_etimer.timer.interval ||
+       wheel_etimer.timer.interval - elapsed <= left) {
+      return;
+    }
+  }
+  PROCESS_CONTEXT_BEGIN(&ctimer_process);
+  etimer_set(&wheel_etimer, left);
+  PROCESS_CONTEXT_END(&ctimer_process);
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_timer(struct ctimer *c)
+{
+  clock_time_t now, due;
+
+  unlink_timer(c);
+
+  now = clock_time();
+  if(wheel_count == 0) {
+    /* Nothing is pending, so no slot needs to be processed before now */
+    wheel_time = now;
+  }
+  due = now + time_left(c, now);
+  link_timer(&wheel[due & WHEEL_MASK], c);
+  c->etimer.p = &ctimer_process;
+  wheel_count++;
+
+  arm_wheel(due - now, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Move the expired timers of the slots up to now to the expired list */
+static void
+collect_expired(clock_time_t now)
+{
+  struct ctimer *c, *next;
+  clock_time_t ticks;
+
+  ticks = now - wheel_time;
+  if(ticks >= CTIMER_WHEEL_SIZE) {
+    ticks = CTIMER_WHEEL_SIZE - 1;
+  }
+  for(;; ticks--) {
+    for(c = wheel[(now - ticks) & WHEEL_MASK]; c != NULL; c = next) {
+      next = c->next;
+      if(time_left(c, now) == 0) {
+        unlink_timer(c);
+        link_timer(&expired_list, c);
+      }
+    }
+    if(ticks == 0) {
+      break;
+    }
+  }
+  wheel_time = now;
+}
+/*---------------------------------------------------------------------------*/
+/* Find the time until the next pending timer expires */
+static int
+next_expiration(clock_time_t now, clock_time_t *left)
+{
+  struct ctimer *c;
+  clock_time_t k, l, best = 0;
+  int found = 0;
+
+  /* A timer in slot now + k expires in k ticks or in a later turn of
+     the wheel, so once a timer that expires in k ticks has been seen,
+     no later slot can hold an earlier one. */
+  for(k = 0; k < CTIMER_WHEEL_SIZE; k++) {
+    for(c = wheel[(now + k) & WHEEL_MASK]; c != NULL; c = c->next) {
+      /* A timer that has already expired gives 0, so that it is
+         collected on the next run */
+      l = time_left(c, now);
+      if(!found || l < best) {
+        best = l;
+        found = 1;
+      }
+    }
+    if(found && best <= k) {
+      break;
+    }
+  }
+  *left = best;
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ctimer_process, ev, data)
+{
+  struct ctimer *c;
+  clock_time_t now, left;
+
+  PROCESS_BEGIN();
+
+  initialized = 1;
+  if(wheel_count > 0) {
+    /* Timers were set before the process started */
+    arm_wheel(0, 1);
+  }
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_TIMER);
+
+    now = clock_time();
+    collect_expired(now);
+
+    /* Callbacks may set and stop any timer, including the ones still
+       on the expired list */
+    while((c = expired_list) != NULL) {
+      unlink_timer(c);
+      PROCESS_CONTEXT_BEGIN(c->p);
+      if(c->f != NULL) {
+	c->f(c->ptr);
+      }
+      PROCESS_CONTEXT_END(c->p);
+    }
+
+    now = clock_time();
+    if(wheel_count > 0 && next_expiration(now, &left)) {
+      arm_wheel(left, 1);
+    }
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_init(void)
+{
+  initialized = 0;
+  memset(wheel, 0, sizeof(wheel));
+  expired_list = NULL;
+  wheel_count = 0;
+  wheel_time = clock_time();
+  process_start(&ctimer_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_set(struct ctimer *c, clock_time_t t,
+	   void (*f)(void *), void *ptr)
+{
+  PRINTF("ctimer_set %p %u\n", c, (unsigned)t);
+  c->p = PROCESS_CURRENT();
+  c->f = f;
+  c->ptr = ptr;
+  timer_set(&c->etimer.timer, t);
+  add_timer(c);
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_reset(struct ctimer *c)
+{
+  timer_reset(&c->etimer.timer);
+  add_timer(c);
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_restart(struct ctimer *c)
+{
+  timer_restart(&c->etimer.timer);
+  add_timer(c);
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_stop(struct ctimer *c)
+{
+  unlink_timer(c);
+}
+/*---------------------------------------------------------------------------*/
+int
+ctimer_expired(struct ctimer *c)
+{
+  return c->etimer.p == PROCESS_NONE;
+}
+/*---------------------------------------------------------------------------*/
+#else /* CTIMER_WHEEL_SIZE */
+LIST(ctimer_list);
+
 PROCESS(ctimer_process, "Ctimer process");
 PROCESS_THREAD(ctimer_process, ev, data)
 {
@@ -164,5 +431,6 @@ ctimer_expired(struct ctimer *c)
   }
   return 1;
 }
+#endif /* CTIMER_WHEEL_SIZE */
 /*---------------------------------------------------------------------------*/
 /** @} */
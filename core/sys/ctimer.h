@@ -56,8 +56,30 @@
 
 #include "sys/etimer.h"
 
+/**
+ * \brief      Number of slots in the callback timer wheel
+ *
+ *             When non-zero, pending callback timers are kept in a
+ *             hashed timing wheel with this many slots, one clock
+ *             tick per slot, driven by a single event timer. Setting
+ *             and stopping a callback timer then take constant time,
+ *             and callback timers no longer occupy the event timer
+ *             list. Must be a power of two.
+ *
+ *             When zero (the default), each callback timer uses its
+ *             own event timer.
+ */
+#ifdef CTIMER_CONF_WHEEL_SIZE
+#define CTIMER_WHEEL_SIZE CTIMER_CONF_WHEEL_SIZE
+#else /* CTIMER_CONF_WHEEL_SIZE */
+#define CTIMER_WHEEL_SIZE 0
+#endif /* CTIMER_CONF_WHEEL_SIZE */
+
 struct ctimer {
   struct ctimer *next;
+#if CTIMER_WHEEL_SIZE
+  struct ctimer **pprev;
+#endif /* CTIMER_WHEEL_SIZE */
   struct etimer etimer;
   struct process *p;
   void (*f)(void *);
@@ -143,6 +165,7 @@ int ctimer_expired(struct ctimer *c);
  */
 void ctimer_init(void);
 
+PROCESS_NAME(ctimer_process);
 #endif /* CTIMER_H_ */
 /** @} */
 /** @} */
@@ -49,31 +49,215 @@
 #include "sys/etimer.h"
 #include "sys/process.h"
 
+#if ETIMER_HEAP_DEBUG
+#include <stdio.h>
+#endif /* ETIMER_HEAP_DEBUG */
+
 static struct etimer *timerlist;
 static clock_time_t next_expiration;
 
+#if ETIMER_HEAP_SIZE
+#if ETIMER_HEAP_SIZE > 0xffff
+#error ETIMER_CONF_HEAP_SIZE must not be larger than 65535
+#endif
+
+/* Binary min-heap of pending event timers, ordered by time left
+   until expiration. Timers that do not fit are kept on timerlist. */
+static struct etimer *heap[ETIMER_HEAP_SIZE];
+static uint16_t heap_count;
+#endif /* ETIMER_HEAP_SIZE */
+
 PROCESS(etimer_process, "Event timer");
 /*---------------------------------------------------------------------------*/
+/*
+ * Time left until the timer expires, or zero if it already has. This
+ * uses the same wrap-safe arithmetic as timer_expired(), and the
+ * ordering it gives between two timers does not change as the clock
+ * advances, so it can be used as the heap key.
+ */
+static clock_time_t
+time_left(struct etimer *t, clock_time_t now)
+{
+  clock_time_t elapsed;
+
+  elapsed = now - t->timer.start;
+  if(elapsed >= t->timer.interval) {
+    return 0;
+  }
+  return t->timer.interval - elapsed;
+}
+/*---------------------------------------------------------------------------*/
+#if ETIMER_HEAP_SIZE
+static void
+heap_place(struct etimer *t, uint16_t i)
+{
+  heap[i] = t;
+  t->heap_index = i;
+}
+/*---------------------------------------------------------------------------*/
+/* Move the timer at i towards the leaves while one of its children
+   expires before it. Only the subtree below i needs to be a heap. */
+static void
+heap_sift_down(uint16_t i, clock_time_t now)
+{
+  struct etimer *t;
+  clock_time_t left;
+  uint16_t child;
+
+  t = heap[i];
+  left = time_left(t, now);
+
+  while((child = 2 * i + 1) < heap_count) {
+    if(child + 1 < heap_count &&
+       time_left(heap[child + 1], now) < time_left(heap[child], now)) {
+      child++;
+    }
+    if(left <= time_left(heap[child], now)) {
+      break;
+    }
+    heap_place(heap[child], i);
+    i = child;
+  }
+
+  heap_place(t, i);
+}
+/*---------------------------------------------------------------------------*/
+/* Move the timer at i to its place in an otherwise valid heap */
+static void
+heap_sift(uint16_t i, clock_time_t now)
+{
+  struct etimer *t;
+  clock_time_t left;
+  uint16_t parent;
+
+  t = heap[i];
+  left = time_left(t, now);
+
+  /* Move the timer towards the root while it expires before its
+     parent. */
+  while(i > 0) {
+    parent = (i - 1) / 2;
+    if(time_left(heap[parent], now) <= left) {
+      break;
+    }
+    heap_place(heap[parent], i);
+    i = parent;
+  }
+  heap_place(t, i);
+
+  heap_sift_down(i, now);
+}
+/*---------------------------------------------------------------------------*/
+#if ETIMER_HEAP_DEBUG
+unsigned long etimer_heap_faults;
+
+/* Check that no timer expires before its parent, and that every timer
+   knows its place */
+static void
+heap_check(const char *where)
+{
+  clock_time_t now;
+  uint16_t i;
+
+  now = clock_time();
+  for(i = 0; i < heap_count; i++) {
+    if(heap[i]->heap_index != i) {
+      printf("etimer: %s: timer %p at %u has index %u\n", where,
+             heap[i], i, heap[i]->heap_index);
+      etimer_heap_faults++;
+    }
+    if(i > 0 &&
+       time_left(heap[i], now) < time_left(heap[(i - 1) / 2], now)) {
+      printf("etimer: %s: timer %p at %u expires before its parent\n",
+             where, heap[i], i);
+      etimer_heap_faults++;
+    }
+  }
+}
+#else /* ETIMER_HEAP_DEBUG */
+#define heap_check(where)
+#endif /* ETIMER_HEAP_DEBUG */
+/*---------------------------------------------------------------------------*/
+static int
+heap_contains(struct etimer *t)
+{
+  /* The index is only trusted if it points back to the timer, so
+     that uninitialized timers are never mistaken for queued ones. */
+  return t->heap_index < heap_count && heap[t->heap_index] == t;
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_remove(struct etimer *t)
+{
+  uint16_t i;
+
+  i = t->heap_index;
+  heap_count--;
+  if(i < heap_count) {
+    heap_place(heap[heap_count], i);
+    heap_sift(i, clock_time());
+  }
+  heap[heap_count] = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_remove_process(struct process *p)
+{
+  clock_time_t now;
+  uint16_t i, n;
+
+  /* Drop the timers of the process and rebuild the heap from the
+     remaining ones. */
+  n = 0;
+  for(i = 0; i < heap_count; i++) {
+    if(heap[i]->p != p) {
+      heap_place(heap[i], n++);
+    }
+  }
+  for(i = n; i < heap_count; i++) {
+    heap[i] = NULL;
+  }
+  heap_count = n;
+
+  /* Bottom-up heapify: the subtrees below i are heaps already, but
+     the nodes above it are not, so the timers are only moved down. */
+  now = clock_time();
+  for(i = heap_count / 2; i > 0; i--) {
+    heap_sift_down(i - 1, now);
+  }
+  heap_check("process exit");
+}
+#endif /* ETIMER_HEAP_SIZE */
+/*---------------------------------------------------------------------------*/
 static void
 update_time(void)
 {
   clock_time_t tdist;
   clock_time_t now;
-  struct etimer *t;
+  struct etimer *t, *next;
+
+  next = NULL;
+  tdist = 0;
+  now = clock_time();
+
+#if ETIMER_HEAP_SIZE
+  if(heap_count > 0) {
+    next = heap[0];
+    tdist = time_left(next, now);
+  }
+#endif /* ETIMER_HEAP_SIZE */
+
+  for(t = timerlist; t != NULL; t = t->next) {
+    if(next == NULL || time_left(t, now) < tdist) {
+      next = t;
+      tdist = time_left(t, now);
+    }
+  }
 
-  if (timerlist == NULL) {
+  if(next == NULL) {
     next_expiration = 0;
   } else {
-    now = clock_time();
-    t = timerlist;
-    /* Must calculate distance to next time into account due to wraps */
-    tdist = t->timer.start + t->timer.interval - now;
-    for(t = t->next; t != NULL; t = t->next) {
-      if(t->timer.start + t->timer.interval - now < tdist) {
-	tdist = t->timer.start + t->timer.interval - now;
-      }
-    }
-    next_expiration = now + tdist;
+    next_expiration = next->timer.start + next->timer.interval;
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -84,6 +268,9 @@ PROCESS_THREAD(etimer_process, ev, data)
   PROCESS_BEGIN();
 
   timerlist = NULL;
+#if ETIMER_HEAP_SIZE
+  heap_count = 0;
+#endif /* ETIMER_HEAP_SIZE */
   
   while(1) {
     PROCESS_YIELD();
@@ -91,6 +278,10 @@ PROCESS_THREAD(etimer_process, ev, data)
     if(ev == PROCESS_EVENT_EXITED) {
       struct process *p = data;
 
+#if ETIMER_HEAP_SIZE
+      heap_remove_process(p);
+#endif /* ETIMER_HEAP_SIZE */
+
       while(timerlist != NULL && timerlist->p == p) {
 	timerlist = timerlist->next;
       }
@@ -104,16 +295,32 @@ PROCESS_THREAD(etimer_process, ev, data)
 	    t = t->next;
 	}
       }
+      update_time();
       continue;
     } else if(ev != PROCESS_EVENT_POLL) {
       continue;
     }
 
-  again:
-    
+#if ETIMER_HEAP_SIZE
+    /* Expired timers are always at the top of the heap, so stop at
+       the first one that has not expired yet. */
+    while(heap_count > 0 && timer_expired(&heap[0]->timer)) {
+      t = heap[0];
+      if(process_post(t->p, PROCESS_EVENT_TIMER, t) != PROCESS_ERR_OK) {
+	etimer_request_poll();
+	break;
+      }
+      /* Reset the process ID of the event timer, to signal that the
+	 etimer has expired. This is later checked in the
+	 etimer_expired() function. */
+      t->p = PROCESS_NONE;
+      heap_remove(t);
+    }
+#endif /* ETIMER_HEAP_SIZE */
+
     u = NULL;
-    
-    for(t = timerlist; t != NULL; t = t->next) {
+    t = timerlist;
+    while(t != NULL) {
       if(timer_expired(&t->timer)) {
 	if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
 	  
@@ -127,15 +334,19 @@ PROCESS_THREAD(etimer_process, ev, data)
 	    timerlist = t->next;
 	  }
 	  t->next = NULL;
-	  update_time();
-	  goto again;
+	  /* Continue with the timer that followed the expired one
+	     instead of rescanning the list from the start. */
+	  t = u != NULL ? u->next : timerlist;
+	  continue;
 	} else {
 	  etimer_request_poll();
 	}
       }
       u = t;
+      t = t->next;
     }
-    
+
+    update_time();
   }
   
   PROCESS_END();
@@ -155,6 +366,15 @@ add_timer(struct etimer *timer)
   etimer_request_poll();
 
   if(timer->p != PROCESS_NONE) {
+#if ETIMER_HEAP_SIZE
+    if(heap_contains(timer)) {
+      /* Timer already in the heap, move it to its new position. */
+      timer->p = PROCESS_CURRENT();
+      heap_sift(timer->heap_index, clock_time());
+      update_time();
+      return;
+    }
+#endif /* ETIMER_HEAP_SIZE */
     for(t = timerlist; t != NULL; t = t->next) {
       if(t == timer) {
 	/* Timer already on list, bail out. */
@@ -167,6 +387,14 @@ add_timer(struct etimer *timer)
 
   /* Timer not on list. */
   timer->p = PROCESS_CURRENT();
+#if ETIMER_HEAP_SIZE
+  if(heap_count < ETIMER_HEAP_SIZE) {
+    heap_place(timer, heap_count++);
+    heap_sift(timer->heap_index, clock_time());
+    update_time();
+    return;
+  }
+#endif /* ETIMER_HEAP_SIZE */
   timer->next = timerlist;
   timerlist = timer;
 
@@ -198,6 +426,11 @@ void
 etimer_adjust(struct etimer *et, int timediff)
 {
   et->timer.start += timediff;
+#if ETIMER_HEAP_SIZE
+  if(et->p != PROCESS_NONE && heap_contains(et)) {
+    heap_sift(et->heap_index, clock_time());
+  }
+#endif /* ETIMER_HEAP_SIZE */
   update_time();
 }
 /*---------------------------------------------------------------------------*/
@@ -222,6 +455,11 @@ etimer_start_time(struct etimer *et)
 int
 etimer_pending(void)
 {
+#if ETIMER_HEAP_SIZE
+  if(heap_count > 0) {
+    return 1;
+  }
+#endif /* ETIMER_HEAP_SIZE */
   return timerlist != NULL;
 }
 /*---------------------------------------------------------------------------*/
@@ -236,6 +474,17 @@ etimer_stop(struct etimer *et)
 {
   struct etimer *t;
 
+#if ETIMER_HEAP_SIZE
+  if(et->p != PROCESS_NONE && heap_contains(et)) {
+    heap_remove(et);
+    heap_check("stop");
+    update_time();
+    et->next = NULL;
+    et->p = PROCESS_NONE;
+    return;
+  }
+#endif /* ETIMER_HEAP_SIZE */
+
   /* First check if et is the first event timer on the list. */
   if(et == timerlist) {
     timerlist = timerlist->next;
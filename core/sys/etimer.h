@@ -65,6 +65,44 @@
 #include "sys/timer.h"
 #include "sys/process.h"
 
+/**
+ * \brief      Size of the event timer priority queue
+ *
+ *             When non-zero, pending event timers are kept in a
+ *             binary min-heap of this many entries, ordered by time
+ *             left until expiration. This gives O(1) access to the
+ *             next expiring timer and O(log n) insertion and
+ *             removal. Timers that do not fit in the heap are kept on
+ *             an unsorted overflow list that is scanned as before.
+ *
+ *             When zero (the default), all timers are kept on the
+ *             unsorted list.
+ */
+#ifdef ETIMER_CONF_HEAP_SIZE
+#define ETIMER_HEAP_SIZE ETIMER_CONF_HEAP_SIZE
+#else /* ETIMER_CONF_HEAP_SIZE */
+#define ETIMER_HEAP_SIZE 0
+#endif /* ETIMER_CONF_HEAP_SIZE */
+
+/**
+ * \brief      Check the event timer heap
+ *
+ *             When non-zero, the heap order is checked after a timer
+ *             has been stopped and after the timers of an exited
+ *             process have been removed. Faults are printed and
+ *             counted in etimer_heap_faults. Only meant for
+ *             debugging.
+ */
+#ifdef ETIMER_CONF_HEAP_DEBUG
+#define ETIMER_HEAP_DEBUG ETIMER_CONF_HEAP_DEBUG
+#else /* ETIMER_CONF_HEAP_DEBUG */
+#define ETIMER_HEAP_DEBUG 0
+#endif /* ETIMER_CONF_HEAP_DEBUG */
+
+#if ETIMER_HEAP_SIZE && ETIMER_HEAP_DEBUG
+extern unsigned long etimer_heap_faults;
+#endif /* ETIMER_HEAP_SIZE && ETIMER_HEAP_DEBUG */
+
 /**
  * A timer.
  *
@@ -77,6 +115,9 @@ struct etimer {
   struct timer timer;
   struct etimer *next;
   struct process *p;
+#if ETIMER_HEAP_SIZE
+  uint16_t heap_index;
+#endif /* ETIMER_HEAP_SIZE */
 };
 
 /**
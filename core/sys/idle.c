@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Implementation of the system idle deadline
+ */
+
+/**
+ * \addtogroup idle
+ * @{
+ */
+
+#include "sys/idle.h"
+#include "contiki.h"
+#include "sys/rtimer.h"
+
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+time_until(clock_time_t deadline, clock_time_t now)
+{
+  /* A deadline that is closer in the past than in the future has
+     already passed. */
+  if((clock_time_t)(now - deadline) < (clock_time_t)(deadline - now)) {
+    return 0;
+  }
+  return deadline - now;
+}
+/*---------------------------------------------------------------------------*/
+int
+idle_next_deadline(clock_time_t *deadline)
+{
+  clock_time_t now, left, rtimer_ticks;
+  rtimer_clock_t rtimer_now, rtimer_time;
+  int type;
+
+  if(process_nevents() != 0) {
+    return IDLE_DEADLINE_NOW;
+  }
+
+  type = IDLE_DEADLINE_NONE;
+  now = clock_time();
+  left = 0;
+
+  if(etimer_pending()) {
+    left = time_until(etimer_next_expiration_time(), now);
+    type = IDLE_DEADLINE_TIMER;
+  }
+
+  if(rtimer_pending()) {
+    rtimer_now = RTIMER_NOW();
+    rtimer_time = rtimer_next_expiration_time();
+    /* Real-time tasks run from the timer interrupt, which also ends
+       the sleep, so the deadline is rounded up rather than down. A
+       task that is due in less than a clock tick would otherwise keep
+       the system from sleeping until it has run. */
+    if(RTIMER_CLOCK_LT(rtimer_time, rtimer_now + 1)) {
+      rtimer_ticks = 1;
+    } else {
+      rtimer_ticks = ((unsigned long)(rtimer_clock_t)(rtimer_time - rtimer_now) *
+                      CLOCK_SECOND + RTIMER_SECOND - 1) / RTIMER_SECOND;
+    }
+    if(type == IDLE_DEADLINE_NONE || rtimer_ticks < left) {
+      left = rtimer_ticks;
+      type = IDLE_DEADLINE_TIMER;
+    }
+  }
+
+  if(type == IDLE_DEADLINE_TIMER) {
+    *deadline = now + left;
+  }
+  return type;
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+idle_time_left(clock_time_t max)
+{
+  clock_time_t deadline, left;
+
+  switch(idle_next_deadline(&deadline)) {
+  case IDLE_DEADLINE_NOW:
+    return 0;
+  case IDLE_DEADLINE_TIMER:
+    left = time_until(deadline, clock_time());
+    return left < max ? left : max;
+  default:
+    return max;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Header file for the system idle deadline
+ */
+
+/**
+ * \addtogroup sys
+ * @{
+ */
+
+/**
+ * \defgroup idle System idle deadline
+ * @{
+ *
+ * The idle module tells the platform main loop how long the system
+ * can sleep before it needs the CPU again. It combines pending events
+ * and polls, event timers (including callback timers, which are
+ * driven by event timers) and real-time timers into a single
+ * deadline, so that the main loop can program one wakeup instead of
+ * waking up periodically to check the timers.
+ *
+ */
+
+#ifndef IDLE_H_
+#define IDLE_H_
+
+#include "sys/clock.h"
+
+/**
+ * \name Deadline types
+ * @{
+ */
+/** No events, polls or timers are pending. */
+#define IDLE_DEADLINE_NONE  0
+/** Events or polls are pending and the system should not sleep. */
+#define IDLE_DEADLINE_NOW   1
+/** A timer expires at the returned deadline. */
+#define IDLE_DEADLINE_TIMER 2
+/** @} */
+
+/**
+ * \brief      Get the next time the system needs to run
+ * \param deadline A pointer to where the deadline is stored. The
+ *             deadline is given in clock ticks, as returned by
+ *             clock_time().
+ * \return     One of IDLE_DEADLINE_NONE, IDLE_DEADLINE_NOW or
+ *             IDLE_DEADLINE_TIMER. The deadline is only written for
+ *             IDLE_DEADLINE_TIMER.
+ *
+ *             Real-time timers are rounded up to the next clock
+ *             tick, and one that is already due counts as expiring in
+ *             one tick, as its task is run by the timer interrupt.
+ *             Platforms that keep the real-time timer running in
+ *             low-power mode may instead use
+ *             rtimer_next_expiration_time() directly.
+ */
+int idle_next_deadline(clock_time_t *deadline);
+
+/**
+ * \brief      Get the number of clock ticks the system can sleep
+ * \param max  The longest time to sleep, in clock ticks
+ * \return     The number of clock ticks until the next deadline,
+ *             zero if the system should not sleep at all, or \c max
+ *             if nothing is scheduled before then.
+ */
+clock_time_t idle_time_left(clock_time_t max);
+
+#endif /* IDLE_H_ */
+
+/** @} */
+/** @} */
@@ -44,9 +44,11 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "sys/process.h"
 #include "sys/arg.h"
+#include "lib/memb.h"
 
 /*
  * Pointer to the currently running process structure.
@@ -65,14 +67,59 @@ struct event_data {
   struct process *p;
 };
 
-static process_num_events_t nevents, fevent;
-static struct event_data events[PROCESS_CONF_NUMEVENTS];
+/*
+ * There is one event queue per priority class. The classes are
+ * indexed by rank, with the highest priority class at rank zero. The
+ * process list is kept sorted by rank, and rank_head points to the
+ * first process of each rank in the list.
+ */
+static process_num_events_t nevents;
+static process_num_events_t rank_nevents[PROCESS_NUM_PRIORITIES];
+static process_num_events_t rank_fevent[PROCESS_NUM_PRIORITIES];
+static struct event_data events[PROCESS_NUM_PRIORITIES][PROCESS_CONF_NUMEVENTS];
+static struct process *rank_head[PROCESS_NUM_PRIORITIES];
+
+#if PROCESS_CONF_PRIORITIES
+#if PROCESS_CONF_NUMEVENTS * PROCESS_NUM_PRIORITIES > 255
+#error PROCESS_CONF_NUMEVENTS is too large to be used with PROCESS_CONF_PRIORITIES
+#endif
+static const unsigned char priority_rank[] = {
+  1, /* PROCESS_PRIORITY_NORMAL */
+  0, /* PROCESS_PRIORITY_HIGH */
+  2  /* PROCESS_PRIORITY_LOW */
+};
+#define PROCESS_RANK(p) priority_rank[(p)->priority]
+#define BROADCAST_RANK  priority_rank[PROCESS_PRIORITY_NORMAL]
+#else /* PROCESS_CONF_PRIORITIES */
+#define PROCESS_RANK(p) 0
+#define BROADCAST_RANK  0
+#endif /* PROCESS_CONF_PRIORITIES */
+
+#if PROCESS_CONF_SPILL_NUMEVENTS
+/*
+ * Events that did not fit in a full event queue are kept in a
+ * per-rank FIFO until there is room in the queue again.
+ */
+struct spilled_event {
+  struct spilled_event *next;
+  struct event_data e;
+};
+MEMB(spilled_events, struct spilled_event, PROCESS_CONF_SPILL_NUMEVENTS);
+static struct spilled_event *spill_head[PROCESS_NUM_PRIORITIES];
+static struct spilled_event *spill_tail[PROCESS_NUM_PRIORITIES];
+static unsigned short nspilled;
+#define NSPILLED nspilled
+#else /* PROCESS_CONF_SPILL_NUMEVENTS */
+#define NSPILLED 0
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
 
 #if PROCESS_CONF_STATS
 process_num_events_t process_maxevents;
+struct process_batch_stats process_batch_stats;
 #endif
 
 static volatile unsigned char poll_requested;
+static volatile unsigned char rank_poll_requested[PROCESS_NUM_PRIORITIES];
 
 #define PROCESS_STATE_NONE        0
 #define PROCESS_STATE_RUNNING     1
@@ -80,6 +127,31 @@ static volatile unsigned char poll_requested;
 
 static void call_process(struct process *p, process_event_t ev, process_data_t data);
 
+#if PROCESS_CONF_EVENT_STATS
+#define EVENT_QUEUED(p) do {                                            \
+    if((p) != PROCESS_BROADCAST) {                                      \
+      (p)->stats.posted++;                                              \
+      if(++(p)->stats.queued > (p)->stats.max_queued) {                 \
+        (p)->stats.max_queued = (p)->stats.queued;                      \
+      }                                                                 \
+    }                                                                   \
+  } while(0)
+#define EVENT_DELIVERED(p) do {                                         \
+    if((p) != PROCESS_BROADCAST) {                                      \
+      (p)->stats.queued--;                                              \
+    }                                                                   \
+  } while(0)
+#define EVENT_DROPPED(p) do {                                           \
+    if((p) != PROCESS_BROADCAST) {                                      \
+      (p)->stats.dropped++;                                             \
+    }                                                                   \
+  } while(0)
+#else /* PROCESS_CONF_EVENT_STATS */
+#define EVENT_QUEUED(p)
+#define EVENT_DELIVERED(p)
+#define EVENT_DROPPED(p)
+#endif /* PROCESS_CONF_EVENT_STATS */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -95,6 +167,59 @@ process_alloc_event(void)
   return lastevent++;
 }
 /*---------------------------------------------------------------------------*/
+static void
+update_rank_heads(void)
+{
+  struct process *q;
+  unsigned char r;
+
+  for(r = 0; r < PROCESS_NUM_PRIORITIES; r++) {
+    rank_head[r] = NULL;
+  }
+  for(q = process_list; q != NULL; q = q->next) {
+    if(rank_head[PROCESS_RANK(q)] == NULL) {
+      rank_head[PROCESS_RANK(q)] = q;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+insert_process(struct process *p)
+{
+  struct process *q;
+
+  /* Put the process first among the processes of the same rank. */
+  if(process_list == NULL || PROCESS_RANK(process_list) >= PROCESS_RANK(p)) {
+    p->next = process_list;
+    process_list = p;
+  } else {
+    for(q = process_list;
+	q->next != NULL && PROCESS_RANK(q->next) < PROCESS_RANK(p);
+	q = q->next);
+    p->next = q->next;
+    q->next = p;
+  }
+  update_rank_heads();
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_process(struct process *p)
+{
+  struct process *q;
+
+  if(p == process_list) {
+    process_list = process_list->next;
+  } else {
+    for(q = process_list; q != NULL; q = q->next) {
+      if(q->next == p) {
+	q->next = p->next;
+	break;
+      }
+    }
+  }
+  update_rank_heads();
+}
+/*---------------------------------------------------------------------------*/
 void
 process_start(struct process *p, process_data_t data)
 {
@@ -109,8 +234,7 @@ process_start(struct process *p, process_data_t data)
     return;
   }
   /* Put on the procs list.*/
-  p->next = process_list;
-  process_list = p;
+  insert_process(p);
   p->state = PROCESS_STATE_RUNNING;
   PT_INIT(&p->pt);
 
@@ -157,16 +281,7 @@ exit_process(struct process *p, struct process *fromprocess)
     }
   }
 
-  if(p == process_list) {
-    process_list = process_list->next;
-  } else {
-    for(q = process_list; q != NULL; q = q->next) {
-      if(q->next == p) {
-	q->next = p->next;
-	break;
-      }
-    }
-  }
+  remove_process(p);
 
   process_current = old_current;
 }
@@ -205,13 +320,47 @@ process_exit(struct process *p)
 }
 /*---------------------------------------------------------------------------*/
 void
+process_set_priority(struct process *p, unsigned char priority)
+{
+#if PROCESS_CONF_PRIORITIES
+  struct process *q;
+
+  for(q = process_list; q != p && q != NULL; q = q->next);
+
+  if(q == p) {
+    /* The process is running, so move it to its new place in the
+       process list. */
+    remove_process(p);
+    p->priority = priority;
+    insert_process(p);
+  } else {
+    p->priority = priority;
+  }
+#endif /* PROCESS_CONF_PRIORITIES */
+}
+/*---------------------------------------------------------------------------*/
+void
 process_init(void)
 {
+  unsigned char r;
+
   lastevent = PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  nevents = 0;
+  for(r = 0; r < PROCESS_NUM_PRIORITIES; r++) {
+    rank_nevents[r] = rank_fevent[r] = 0;
+    rank_head[r] = NULL;
+#if PROCESS_CONF_SPILL_NUMEVENTS
+    spill_head[r] = spill_tail[r] = NULL;
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
+  }
+#if PROCESS_CONF_SPILL_NUMEVENTS
+  memb_init(&spilled_events);
+  nspilled = 0;
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
+  memset(&process_batch_stats, 0, sizeof(process_batch_stats));
 #endif /* PROCESS_CONF_STATS */
 
   process_current = process_list = NULL;
@@ -225,14 +374,22 @@ static void
 do_poll(void)
 {
   struct process *p;
+  unsigned char r;
 
   poll_requested = 0;
-  /* Call the processes that needs to be polled. */
-  for(p = process_list; p != NULL; p = p->next) {
-    if(p->needspoll) {
-      p->state = PROCESS_STATE_RUNNING;
-      p->needspoll = 0;
-      call_process(p, PROCESS_EVENT_POLL, NULL);
+  /* Call the processes that needs to be polled, highest priority
+     first. Only the priority classes in which a poll was requested
+     are visited. */
+  for(r = 0; r < PROCESS_NUM_PRIORITIES; r++) {
+    if(rank_poll_requested[r]) {
+      rank_poll_requested[r] = 0;
+      for(p = rank_head[r]; p != NULL && PROCESS_RANK(p) == r; p = p->next) {
+	if(p->needspoll) {
+	  p->state = PROCESS_STATE_RUNNING;
+	  p->needspoll = 0;
+	  call_process(p, PROCESS_EVENT_POLL, NULL);
+	}
+      }
     }
   }
 }
@@ -249,6 +406,7 @@ do_event(void)
   static process_data_t data;
   static struct process *receiver;
   static struct process *p;
+  static unsigned char r;
   
   /*
    * If there are any events in the queue, take the first one and walk
@@ -259,17 +417,40 @@ do_event(void)
    */
 
   if(nevents > 0) {
-    
+
+    /* Take the event from the highest priority queue that is not
+       empty. */
+    for(r = 0; rank_nevents[r] == 0; r++);
+
     /* There are events that we should deliver. */
-    ev = events[fevent].ev;
+    ev = events[r][rank_fevent[r]].ev;
     
-    data = events[fevent].data;
-    receiver = events[fevent].p;
+    data = events[r][rank_fevent[r]].data;
+    receiver = events[r][rank_fevent[r]].p;
 
     /* Since we have seen the new event, we move pointer upwards
        and decrese the number of events. */
-    fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    rank_fevent[r] = (rank_fevent[r] + 1) % PROCESS_CONF_NUMEVENTS;
+    --rank_nevents[r];
     --nevents;
+    EVENT_DELIVERED(receiver);
+
+#if PROCESS_CONF_SPILL_NUMEVENTS
+    /* Events are only spilled when the queue is full, so the oldest
+       spilled event goes into the slot that was just freed. */
+    if(spill_head[r] != NULL) {
+      struct spilled_event *s = spill_head[r];
+      spill_head[r] = s->next;
+      if(spill_head[r] == NULL) {
+	spill_tail[r] = NULL;
+      }
+      events[r][(rank_fevent[r] + rank_nevents[r]) % PROCESS_CONF_NUMEVENTS] = s->e;
+      ++rank_nevents[r];
+      ++nevents;
+      --nspilled;
+      memb_free(&spilled_events, s);
+    }
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
 
     /* If this is a broadcast event, we deliver it to all events, in
        order of their priority. */
@@ -309,19 +490,52 @@ process_run(void)
   /* Process one event from the queue */
   do_event();
 
-  return nevents + poll_requested;
+  return nevents + NSPILLED + poll_requested;
+}
+/*---------------------------------------------------------------------------*/
+int
+process_run_batch(unsigned int max_events, clock_time_t max_time)
+{
+  unsigned int delivered;
+  clock_time_t start;
+
+  delivered = 0;
+  start = max_time != 0 ? clock_time() : 0;
+
+  do {
+    if(poll_requested) {
+      do_poll();
+    }
+    if(nevents > 0) {
+      do_event();
+      delivered++;
+    }
+  } while((nevents > 0 || poll_requested) &&
+	  (max_events == 0 || delivered < max_events) &&
+	  (max_time == 0 || (clock_time_t)(clock_time() - start) < max_time));
+
+#if PROCESS_CONF_STATS
+  process_batch_stats.passes++;
+  process_batch_stats.events += delivered;
+  if(delivered > process_batch_stats.max_events) {
+    process_batch_stats.max_events = delivered;
+  }
+#endif /* PROCESS_CONF_STATS */
+
+  return nevents + NSPILLED + poll_requested;
 }
 /*---------------------------------------------------------------------------*/
 int
 process_nevents(void)
 {
-  return nevents + poll_requested;
+  return nevents + NSPILLED + poll_requested;
 }
 /*---------------------------------------------------------------------------*/
 int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
   static process_num_events_t snum;
+  unsigned char r;
 
   if(PROCESS_CURRENT() == NULL) {
     PRINTF("process_post: NULL process posts event %d to process '%s', nevents %d\n",
@@ -332,7 +546,28 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
 	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), nevents);
   }
   
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  r = p == PROCESS_BROADCAST ? BROADCAST_RANK : PROCESS_RANK(p);
+
+  if(rank_nevents[r] == PROCESS_CONF_NUMEVENTS) {
+#if PROCESS_CONF_SPILL_NUMEVENTS
+    struct spilled_event *s = memb_alloc(&spilled_events);
+    if(s != NULL) {
+      s->e.ev = ev;
+      s->e.data = data;
+      s->e.p = p;
+      s->next = NULL;
+      if(spill_tail[r] != NULL) {
+	spill_tail[r]->next = s;
+      } else {
+	spill_head[r] = s;
+      }
+      spill_tail[r] = s;
+      ++nspilled;
+      EVENT_QUEUED(p);
+      return PROCESS_ERR_OK;
+    }
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
+    EVENT_DROPPED(p);
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, PROCESS_NAME_STRING(process_current));
@@ -343,11 +578,13 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
     return PROCESS_ERR_FULL;
   }
   
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
-  events[snum].ev = ev;
-  events[snum].data = data;
-  events[snum].p = p;
+  snum = (process_num_events_t)(rank_fevent[r] + rank_nevents[r]) % PROCESS_CONF_NUMEVENTS;
+  events[r][snum].ev = ev;
+  events[r][snum].data = data;
+  events[r][snum].p = p;
+  ++rank_nevents[r];
   ++nevents;
+  EVENT_QUEUED(p);
 
 #if PROCESS_CONF_STATS
   if(nevents > process_maxevents) {
@@ -374,6 +611,7 @@ process_poll(struct process *p)
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
       p->needspoll = 1;
+      rank_poll_requested[PROCESS_RANK(p)] = 1;
       poll_requested = 1;
     }
   }
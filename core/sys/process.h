@@ -55,6 +55,7 @@
 
 #include "sys/pt.h"
 #include "sys/cc.h"
+#include "sys/clock.h"
 
 typedef unsigned char process_event_t;
 typedef void *        process_data_t;
@@ -88,6 +89,60 @@ typedef unsigned char process_num_events_t;
 #define PROCESS_CONF_NUMEVENTS 32
 #endif /* PROCESS_CONF_NUMEVENTS */
 
+/**
+ * \name Process priorities
+ *
+ * When PROCESS_CONF_PRIORITIES is set, every process belongs to one
+ * of three priority classes. Each class has its own event queue of
+ * PROCESS_CONF_NUMEVENTS entries, and pending polls and events for
+ * processes in a higher class are always delivered before those of a
+ * lower class. Processes are in the normal class unless
+ * process_set_priority() is called. Broadcast events are queued in
+ * the normal class.
+ *
+ * @{
+ */
+#ifndef PROCESS_CONF_PRIORITIES
+#define PROCESS_CONF_PRIORITIES 0
+#endif /* PROCESS_CONF_PRIORITIES */
+
+#define PROCESS_PRIORITY_NORMAL 0
+#define PROCESS_PRIORITY_HIGH   1
+#define PROCESS_PRIORITY_LOW    2
+
+#if PROCESS_CONF_PRIORITIES
+#define PROCESS_NUM_PRIORITIES  3
+#else /* PROCESS_CONF_PRIORITIES */
+#define PROCESS_NUM_PRIORITIES  1
+#endif /* PROCESS_CONF_PRIORITIES */
+/** @} */
+
+/**
+ * \brief Number of events that can be spilled when an event queue is full
+ *
+ * When an event queue is full, up to PROCESS_CONF_SPILL_NUMEVENTS
+ * further events are kept in a secondary queue, allocated with memb,
+ * instead of being rejected with PROCESS_ERR_FULL. Spilled events are
+ * delivered in the order they were posted. The spill area is shared
+ * between all priority classes. The default is zero, which disables
+ * the spill area.
+ */
+#ifndef PROCESS_CONF_SPILL_NUMEVENTS
+#define PROCESS_CONF_SPILL_NUMEVENTS 0
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
+
+/**
+ * \brief Keep per-process event queue statistics
+ *
+ * When set, every process records how many events were posted to it,
+ * how many were dropped because the event queue was full, and the
+ * largest number of its events that were queued at the same
+ * time. Broadcast events are not included.
+ */
+#ifndef PROCESS_CONF_EVENT_STATS
+#define PROCESS_CONF_EVENT_STATS 0
+#endif /* PROCESS_CONF_EVENT_STATS */
+
 #define PROCESS_EVENT_NONE            0x80
 #define PROCESS_EVENT_INIT            0x81
 #define PROCESS_EVENT_POLL            0x82
@@ -312,6 +367,22 @@ static PT_THREAD(process_thread_##name(struct pt *process_pt,	\
 
 /** @} */
 
+#if PROCESS_CONF_EVENT_STATS
+/**
+ * Event queue statistics of a process.
+ */
+struct process_event_stats {
+  /** Number of events that were posted to the process. */
+  unsigned long posted;
+  /** Number of events that were dropped because the queue was full. */
+  unsigned long dropped;
+  /** Number of events currently queued for the process. */
+  unsigned short queued;
+  /** Largest number of events queued for the process at once. */
+  unsigned short max_queued;
+};
+#endif /* PROCESS_CONF_EVENT_STATS */
+
 struct process {
   struct process *next;
 #if PROCESS_CONF_NO_PROCESS_NAMES
@@ -323,6 +394,12 @@ struct process {
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
   unsigned char state, needspoll;
+#if PROCESS_CONF_PRIORITIES
+  unsigned char priority;
+#endif /* PROCESS_CONF_PRIORITIES */
+#if PROCESS_CONF_EVENT_STATS
+  struct process_event_stats stats;
+#endif /* PROCESS_CONF_EVENT_STATS */
 };
 
 /**
@@ -389,6 +466,19 @@ CCIF void process_post_synch(struct process *p,
  */
 CCIF void process_exit(struct process *p);
 
+/**
+ * \brief      Set the priority class of a process
+ * \param p    The process
+ * \param priority PROCESS_PRIORITY_HIGH, PROCESS_PRIORITY_NORMAL or
+ *             PROCESS_PRIORITY_LOW
+ *
+ *             This function moves a process to another priority
+ *             class. It is typically called by the boot-up code
+ *             before the process is started. It does nothing unless
+ *             PROCESS_CONF_PRIORITIES is set.
+ */
+void process_set_priority(struct process *p, unsigned char priority);
+
 
 /**
  * Get a pointer to the currently running process.
@@ -499,6 +589,42 @@ void process_init(void);
  */
 int process_run(void);
 
+/**
+ * Run the system for a batch of events.
+ *
+ * This function works like process_run(), but keeps calling poll
+ * handlers and delivering events until there is nothing more to do,
+ * until \c max_events events have been delivered, or until \c
+ * max_time clock ticks have passed. At least one event is delivered
+ * if any is pending. This lets the main() program process a burst of
+ * events without paying its own loop overhead between each of them.
+ *
+ * \param max_events The largest number of events to deliver, or zero
+ * for no limit.
+ *
+ * \param max_time The longest time to spend, in clock ticks, or zero
+ * for no limit.
+ *
+ * \return The number of events that are currently waiting in the
+ * event queue.
+ */
+int process_run_batch(unsigned int max_events, clock_time_t max_time);
+
+#if PROCESS_CONF_STATS
+/**
+ * Statistics for process_run_batch().
+ */
+struct process_batch_stats {
+  /** The number of calls to process_run_batch(). */
+  unsigned long passes;
+  /** The total number of events delivered by process_run_batch(). */
+  unsigned long events;
+  /** The largest number of events delivered in a single call. */
+  unsigned int max_events;
+};
+extern struct process_batch_stats process_batch_stats;
+#endif /* PROCESS_CONF_STATS */
+
 
 /**
  * Check if a process is running.
@@ -56,6 +56,30 @@
 
 static struct rtimer *next_rtimer;
 
+#if RTIMER_CONF_STATS
+struct rtimer_stats rtimer_stats;
+
+/* Record how late a task is executed */
+static void
+update_stats(struct rtimer *t)
+{
+  rtimer_clock_t now = RTIMER_NOW();
+
+  rtimer_stats.executed++;
+  if(RTIMER_CLOCK_LT(t->time, now)) {
+    rtimer_clock_t late = now - t->time;
+    rtimer_stats.late++;
+    rtimer_stats.total_late += late;
+    if(late > rtimer_stats.max_late) {
+      rtimer_stats.max_late = late;
+    }
+  }
+}
+#define UPDATE_STATS(t) update_stats(t)
+#else /* RTIMER_CONF_STATS */
+#define UPDATE_STATS(t)
+#endif /* RTIMER_CONF_STATS */
+
 /*---------------------------------------------------------------------------*/
 void
 rtimer_init(void)
@@ -63,6 +87,110 @@ rtimer_init(void)
   rtimer_arch_init();
 }
 /*---------------------------------------------------------------------------*/
+#if RTIMER_MULTIPLE
+/* next_rtimer is the head of the queue of pending tasks, sorted by
+   execution time. Must be called with the timer interrupt disabled. */
+static void
+remove_rtimer(struct rtimer *rtimer)
+{
+  struct rtimer **tp;
+
+  for(tp = &next_rtimer; *tp != NULL; tp = &(*tp)->next) {
+    if(*tp == rtimer) {
+      *tp = rtimer->next;
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+rtimer_set(struct rtimer *rtimer, rtimer_clock_t time,
+	   rtimer_clock_t duration,
+	   rtimer_callback_t func, void *ptr)
+{
+  struct rtimer **tp;
+  struct rtimer *head;
+  rtimer_clock_t head_time;
+  rtimer_arch_atomic_t s;
+
+  PRINTF("rtimer_set time %d\n", time);
+
+  RTIMER_ARCH_ATOMIC_BEGIN(s);
+  head = next_rtimer;
+  head_time = head != NULL ? head->time : 0;
+  remove_rtimer(rtimer);
+
+  rtimer->func = func;
+  rtimer->ptr = ptr;
+  rtimer->time = time;
+
+  /* Tasks with the same time are executed in the order they were set */
+  for(tp = &next_rtimer; *tp != NULL; tp = &(*tp)->next) {
+    if(RTIMER_CLOCK_LT(time, (*tp)->time)) {
+      break;
+    }
+  }
+  rtimer->next = *tp;
+  *tp = rtimer;
+
+  /* The earliest task changes if this one was set before it, or if
+     this one was the earliest and has been set for a later time */
+  if(next_rtimer != head || next_rtimer->time != head_time) {
+    rtimer_arch_schedule(next_rtimer->time);
+  }
+  RTIMER_ARCH_ATOMIC_END(s);
+  return RTIMER_OK;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_run_next(void)
+{
+  struct rtimer *t;
+  rtimer_clock_t now;
+  rtimer_arch_atomic_t s;
+  unsigned int i, n;
+
+  /* Count the tasks whose time has come, and execute at most that many,
+     so that a task that sets itself again for a time that has already
+     passed is executed on the next interrupt instead of in a loop here.
+     Tasks that are not due yet, e.g. if the timer fired early, are left
+     for the interrupt scheduled below. */
+  RTIMER_ARCH_ATOMIC_BEGIN(s);
+  now = RTIMER_NOW();
+  n = 0;
+  for(t = next_rtimer; t != NULL; t = t->next) {
+    if(RTIMER_CLOCK_LT(now, t->time)) {
+      break;
+    }
+    n++;
+  }
+  RTIMER_ARCH_ATOMIC_END(s);
+
+  for(i = 0; i < n; i++) {
+    RTIMER_ARCH_ATOMIC_BEGIN(s);
+    t = next_rtimer;
+    if(t != NULL && !RTIMER_CLOCK_LT(now, t->time)) {
+      next_rtimer = t->next;
+      t->next = NULL;
+    } else {
+      t = NULL;
+    }
+    RTIMER_ARCH_ATOMIC_END(s);
+    if(t == NULL) {
+      break;
+    }
+    UPDATE_STATS(t);
+    t->func(t, t->ptr);
+  }
+
+  RTIMER_ARCH_ATOMIC_BEGIN(s);
+  if(next_rtimer != NULL) {
+    rtimer_arch_schedule(next_rtimer->time);
+  }
+  RTIMER_ARCH_ATOMIC_END(s);
+}
+/*---------------------------------------------------------------------------*/
+#else /* RTIMER_MULTIPLE */
 int
 rtimer_set(struct rtimer *rtimer, rtimer_clock_t time,
 	   rtimer_clock_t duration,
@@ -97,12 +225,26 @@ rtimer_run_next(void)
   }
   t = next_rtimer;
   next_rtimer = NULL;
+  UPDATE_STATS(t);
   t->func(t, t->ptr);
   if(next_rtimer != NULL) {
     rtimer_arch_schedule(next_rtimer->time);
   }
   return;
 }
+#endif /* RTIMER_MULTIPLE */
+/*---------------------------------------------------------------------------*/
+int
+rtimer_pending(void)
+{
+  return next_rtimer != NULL;
+}
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+rtimer_next_expiration_time(void)
+{
+  return next_rtimer != NULL ? next_rtimer->time : 0;
+}
 /*---------------------------------------------------------------------------*/
 
 /** @}*/
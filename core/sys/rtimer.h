@@ -62,6 +62,34 @@ typedef unsigned short rtimer_clock_t;
 
 #include "rtimer-arch.h"
 
+/**
+ * \brief      Allow more than one pending real-time task
+ *
+ *             When non-zero, pending real-time tasks are kept on a
+ *             queue sorted by execution time, and the hardware timer
+ *             is always programmed for the earliest one. When zero
+ *             (the default), only one task can be pending and
+ *             rtimer_set() replaces it.
+ */
+#ifdef RTIMER_CONF_MULTIPLE
+#define RTIMER_MULTIPLE RTIMER_CONF_MULTIPLE
+#else /* RTIMER_CONF_MULTIPLE */
+#define RTIMER_MULTIPLE 0
+#endif /* RTIMER_CONF_MULTIPLE */
+
+/*
+ * The task queue is changed both from the main loop and from real-time
+ * task callbacks, which run in interrupt context. An architecture that
+ * uses RTIMER_CONF_MULTIPLE must define rtimer_arch_atomic_t and
+ * RTIMER_ARCH_ATOMIC_BEGIN(s)/RTIMER_ARCH_ATOMIC_END(s) in
+ * rtimer-arch.h to keep the timer interrupt out while the queue is
+ * changed. The state s is saved so that the macros can also be used
+ * with interrupts already disabled.
+ */
+#if RTIMER_MULTIPLE && !defined(RTIMER_ARCH_ATOMIC_BEGIN)
+#error "RTIMER_CONF_MULTIPLE requires RTIMER_ARCH_ATOMIC_BEGIN/END in rtimer-arch.h"
+#endif
+
 /**
  * \brief      Initialize the real-time scheduler.
  *
@@ -82,6 +110,9 @@ typedef void (* rtimer_callback_t)(struct rtimer *t, void *ptr);
  *             support module for the real-time module.
  */
 struct rtimer {
+#if RTIMER_MULTIPLE
+  struct rtimer *next;
+#endif /* RTIMER_MULTIPLE */
   rtimer_clock_t time;
   rtimer_callback_t func;
   void *ptr;
@@ -94,6 +125,23 @@ enum {
   RTIMER_ERR_ALREADY_SCHEDULED,
 };
 
+#if RTIMER_CONF_STATS
+/**
+ * Timing statistics of the real-time tasks that have been executed.
+ */
+struct rtimer_stats {
+  /** The number of tasks executed. */
+  unsigned long executed;
+  /** The number of tasks executed after their scheduled time. */
+  unsigned long late;
+  /** The sum of the lateness of all tasks, in rtimer ticks. */
+  unsigned long total_late;
+  /** The largest lateness of any task, in rtimer ticks. */
+  rtimer_clock_t max_late;
+};
+extern struct rtimer_stats rtimer_stats;
+#endif /* RTIMER_CONF_STATS */
+
 /**
  * \brief      Post a real-time task.
  * \param task A pointer to the task variable previously declared with RTIMER_TASK().
@@ -105,7 +153,9 @@ enum {
  *             (false) if the task could not be scheduled.
  *
  *             This function schedules a real-time task at a specified
- *             time in the future.
+ *             time in the future. With RTIMER_CONF_MULTIPLE, a task
+ *             that is already pending is moved to its new time;
+ *             otherwise the task replaces any pending task.
  *
  */
 int rtimer_set(struct rtimer *task, rtimer_clock_t time,
@@ -116,10 +166,27 @@ int rtimer_set(struct rtimer *task, rtimer_clock_t time,
  *
  *             This function is called by the architecture dependent
  *             code to execute and schedule the next real-time task.
+ *             With RTIMER_CONF_MULTIPLE, all tasks whose time has
+ *             come are executed in order.
  *
  */
 void rtimer_run_next(void);
 
+/**
+ * \brief      Check if a real-time task is scheduled
+ * \return     Non-zero if a real-time task is waiting to be executed,
+ *             zero otherwise.
+ */
+int rtimer_pending(void);
+
+/**
+ * \brief      Get the execution time of the next real-time task
+ * \return     The time when the next real-time task is executed. The
+ *             value is only valid if rtimer_pending() returns
+ *             non-zero.
+ */
+rtimer_clock_t rtimer_next_expiration_time(void);
+
 /**
  * \brief      Get the current clock time
  * \return     The current time
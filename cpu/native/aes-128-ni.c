@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         AES-128 driver that uses the AES-NI instructions of the host
+ *         processor, when available, and the software driver otherwise
+ */
+
+#include "lib/aes-128.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <wmmintrin.h>
+
+#define AES_NI_TARGET __attribute__((target("aes,sse2")))
+
+/* 0 = not checked yet, 1 = available, 2 = not available */
+static uint8_t have_aes_ni;
+static __m128i round_keys[11];
+
+/*---------------------------------------------------------------------------*/
+static int
+aes_ni_available(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if(have_aes_ni == 0) {
+    have_aes_ni = 2;
+    if(__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES)) {
+      have_aes_ni = 1;
+    }
+  }
+  return have_aes_ni == 1;
+}
+/*---------------------------------------------------------------------------*/
+AES_NI_TARGET static void
+set_key(uint8_t *key)
+{
+  const uint8_t *expanded;
+  uint8_t i;
+
+  if(!aes_ni_available()) {
+    aes_128_driver.set_key(key);
+    return;
+  }
+
+  /* the key schedule is shared with the software driver */
+  expanded = aes_128_round_keys(key);
+  for(i = 0; i < 11; i++) {
+    round_keys[i] = _mm_loadu_si128((const __m128i *)(expanded + i * AES_128_BLOCK_SIZE));
+  }
+}
+/*---------------------------------------------------------------------------*/
+AES_NI_TARGET static void
+encrypt(uint8_t *state)
+{
+  __m128i block;
+  uint8_t round;
+
+  if(!aes_ni_available()) {
+    aes_128_driver.encrypt(state);
+    return;
+  }
+
+  block = _mm_xor_si128(_mm_loadu_si128((const __m128i *)state), round_keys[0]);
+  for(round = 1; round < 10; round++) {
+    block = _mm_aesenc_si128(block, round_keys[round]);
+  }
+  block = _mm_aesenclast_si128(block, round_keys[10]);
+  _mm_storeu_si128((__m128i *)state, block);
+}
+/*---------------------------------------------------------------------------*/
+const struct aes_128_driver aes_128_ni_driver = {
+  set_key,
+  encrypt
+};
+#else /* x86 */
+/*---------------------------------------------------------------------------*/
+static void
+set_key(uint8_t *key)
+{
+  aes_128_driver.set_key(key);
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *state)
+{
+  aes_128_driver.encrypt(state);
+}
+/*---------------------------------------------------------------------------*/
+const struct aes_128_driver aes_128_ni_driver = {
+  set_key,
+  encrypt
+};
+#endif /* x86 */
+/*---------------------------------------------------------------------------*/
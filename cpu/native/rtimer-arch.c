@@ -78,7 +78,11 @@ rtimer_arch_schedule(rtimer_clock_t t)
   rtimer_clock_t c;
 
   c = t - (unsigned short)clock_time();
-  
+  if(RTIMER_CLOCK_LT(t, (unsigned short)clock_time() + 1)) {
+    /* Due already: a zero timer value would disarm the timer */
+    c = 1;
+  }
+
   val.it_value.tv_sec = c / 1000;
   val.it_value.tv_usec = (c % 1000) * 1000;
 
@@ -90,3 +94,15 @@ rtimer_arch_schedule(rtimer_clock_t t)
 #endif /* !_WIN32 */
 }
 /*---------------------------------------------------------------------------*/
+#ifndef _WIN32
+void
+rtimer_arch_block(sigset_t *old)
+{
+  sigset_t set;
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGALRM);
+  sigprocmask(SIG_BLOCK, &set, old);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* !_WIN32 */
@@ -46,4 +46,21 @@
 
 #define rtimer_arch_now() clock_time()
 
+#ifndef _WIN32
+#include <signal.h>
+
+/* Real-time tasks run from the SIGALRM handler, so the task queue is
+   protected by blocking SIGALRM. */
+typedef sigset_t rtimer_arch_atomic_t;
+#define RTIMER_ARCH_ATOMIC_BEGIN(s) rtimer_arch_block(&(s))
+#define RTIMER_ARCH_ATOMIC_END(s)   sigprocmask(SIG_SETMASK, &(s), NULL)
+
+void rtimer_arch_block(sigset_t *old);
+#else /* !_WIN32 */
+/* Real-time tasks are never run from an interrupt */
+typedef int rtimer_arch_atomic_t;
+#define RTIMER_ARCH_ATOMIC_BEGIN(s) ((void)(s))
+#define RTIMER_ARCH_ATOMIC_END(s)   ((void)(s))
+#endif /* !_WIN32 */
+
 #endif /* RTIMER_ARCH_H_ */
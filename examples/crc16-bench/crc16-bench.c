@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of crc16_data().
+ *
+ *         Blocks of different sizes are checksummed byte by byte with
+ *         crc16_add() and in one call to crc16_data(), and the
+ *         throughput of both is printed. The number of tables used by
+ *         crc16_data() is set with CRC16_CONF_SLICES; build with
+ *         e.g. "make SLICES=0" (after "make clean") to compare with
+ *         the bitwise crc16_data(). The results of the two functions
+ *         are also checked against each other.
+ */
+
+#include "contiki.h"
+#include "lib/crc16.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+
+#define MAX_BLOCK 1024
+/* Blocks are checksummed in batches of BATCH_BYTES until at least
+   MIN_TIME has passed, so that the clock resolution does not limit the
+   precision of the results */
+#define BATCH_BYTES (64UL * 1024)
+#define MIN_TIME    CLOCK_SECOND
+
+static unsigned char block[MAX_BLOCK];
+
+PROCESS(crc16_bench_process, "CRC16 benchmark");
+AUTOSTART_PROCESSES(&crc16_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned short
+crc16_bytewise(const unsigned char *data, int len, unsigned short acc)
+{
+  while(len-- > 0) {
+    acc = crc16_add(*data++, acc);
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the throughput in kilobytes per second */
+static unsigned long
+measure(unsigned short (*f)(const unsigned char *, int, unsigned short),
+        int len)
+{
+  unsigned long i, rounds, kbytes, bytes;
+  clock_time_t start, elapsed;
+  volatile unsigned short acc;
+
+  rounds = BATCH_BYTES / len;
+  acc = 0;
+  kbytes = bytes = 0;
+  start = clock_time();
+  do {
+    for(i = 0; i < rounds; i++) {
+      acc = f(block, len, acc);
+    }
+    bytes += rounds * len;
+    kbytes += bytes / 1024;
+    bytes %= 1024;
+    elapsed = clock_time() - start;
+  } while(elapsed < MIN_TIME);
+  return kbytes * CLOCK_SECOND / elapsed;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(crc16_bench_process, ev, data)
+{
+  static const int lengths[] = { 8, 32, 128, 1024 };
+  unsigned long mismatches;
+  int i, len, offset;
+
+  PROCESS_BEGIN();
+
+  random_init(1);
+  for(i = 0; i < MAX_BLOCK; i++) {
+    block[i] = random_rand();
+  }
+
+  /* All lengths and alignments, with a running checksum */
+  mismatches = 0;
+  for(len = 0; len <= 64; len++) {
+    for(offset = 0; offset < 8; offset++) {
+      if(crc16_data(block + offset, len, len * offset) !=
+         crc16_bytewise(block + offset, len, len * offset)) {
+        mismatches++;
+      }
+    }
+  }
+  printf("crc16_data with %d tables: %lu mismatches\n",
+         CRC16_SLICES, mismatches);
+
+  for(i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    printf("%4d byte blocks: crc16_add %lu kB/s, crc16_data %lu kB/s\n",
+           lengths[i], measure(crc16_bytewise, lengths[i]),
+           measure(crc16_data, lengths[i]));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Randomized test of the event timer heap.
+ *
+ *         Timers owned by a few worker processes are set and stopped
+ *         at random, and the workers exit and are restarted, which
+ *         removes all their timers at once. The heap order is
+ *         checked after each stop and exit (ETIMER_CONF_HEAP_DEBUG
+ *         in project-conf.h). The test also checks that every timer
+ *         expires, and prints how late the latest one was; on a
+ *         loaded host this can be a few ticks even when the heap is
+ *         correct, so lateness alone does not fail the test.
+ */
+
+#include "contiki.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+
+#define WORKERS 4
+#define TIMERS  16
+#define ROUNDS  2000
+#define OPS     2
+#define MAX_INTERVAL (CLOCK_SECOND / 20)
+#define LATE    (CLOCK_SECOND / 50)
+
+struct test_timer {
+  struct etimer et;
+  clock_time_t expires;
+  uint8_t pending;
+};
+
+static struct test_timer timers[WORKERS][TIMERS];
+static unsigned long set_count, fired_count, late_count;
+static clock_time_t max_late;
+
+PROCESS(etimer_heap_test_process, "Etimer heap test");
+PROCESS(worker0, "Worker 0");
+PROCESS(worker1, "Worker 1");
+PROCESS(worker2, "Worker 2");
+PROCESS(worker3, "Worker 3");
+AUTOSTART_PROCESSES(&etimer_heap_test_process);
+
+static struct process * const workers[WORKERS] = {
+  &worker0, &worker1, &worker2, &worker3
+};
+/*---------------------------------------------------------------------------*/
+static void
+fired(int w, struct etimer *et)
+{
+  struct test_timer *t;
+  clock_time_t late;
+
+  t = (struct test_timer *)et;
+  if(t < &timers[w][0] || t >= &timers[w][TIMERS]) {
+    printf("worker %d: event for a timer of another worker\n", w);
+    return;
+  }
+  if(!t->pending || et->p != PROCESS_NONE) {
+    /* Posted before the timer was stopped or set again */
+    return;
+  }
+  t->pending = 0;
+  fired_count++;
+  late = clock_time() - t->expires;
+  if(late > max_late) {
+    max_late = late;
+  }
+  if(late > LATE) {
+    late_count++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+#define WORKER_THREAD(w)                                        \
+  PROCESS_THREAD(worker##w, ev, data)                           \
+  {                                                             \
+    PROCESS_BEGIN();                                            \
+    while(1) {                                                  \
+      PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);      \
+      fired(w, data);                                           \
+    }                                                           \
+    PROCESS_END();                                              \
+  }
+WORKER_THREAD(0)
+WORKER_THREAD(1)
+WORKER_THREAD(2)
+WORKER_THREAD(3)
+/*---------------------------------------------------------------------------*/
+static void
+random_op(void)
+{
+  struct test_timer *t;
+  clock_time_t interval;
+  int w, i;
+
+  w = random_rand() % WORKERS;
+  i = random_rand() % TIMERS;
+  t = &timers[w][i];
+
+  switch(random_rand() % 8) {
+  case 0:
+    /* The worker exits with its timers pending, and starts again */
+    process_exit(workers[w]);
+    for(i = 0; i < TIMERS; i++) {
+      timers[w][i].pending = 0;
+    }
+    process_start(workers[w], NULL);
+    break;
+  case 1:
+  case 2:
+    etimer_stop(&t->et);
+    t->pending = 0;
+    break;
+  default:
+    interval = random_rand() % MAX_INTERVAL;
+    PROCESS_CONTEXT_BEGIN(workers[w]);
+    etimer_set(&t->et, interval);
+    PROCESS_CONTEXT_END(workers[w]);
+    t->expires = etimer_start_time(&t->et) + interval;
+    t->pending = 1;
+    set_count++;
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(etimer_heap_test_process, ev, data)
+{
+  static struct etimer et;
+  static int round;
+  int w, i, missed;
+
+  PROCESS_BEGIN();
+
+  for(w = 0; w < WORKERS; w++) {
+    process_start(workers[w], NULL);
+  }
+
+  for(round = 0; round < ROUNDS; round++) {
+    for(i = 0; i < OPS; i++) {
+      random_op();
+    }
+    etimer_set(&et, 1);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+
+  /* Let the remaining timers expire */
+  etimer_set(&et, MAX_INTERVAL + CLOCK_SECOND / 10);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  missed = 0;
+  for(w = 0; w < WORKERS; w++) {
+    for(i = 0; i < TIMERS; i++) {
+      if(timers[w][i].pending) {
+        missed++;
+      }
+    }
+  }
+  printf("etimer heap test: %lu set, %lu expired, %d missed, %lu late, max lateness %lu ticks\n",
+         set_count, fired_count, missed, late_count, (unsigned long)max_late);
+  printf("etimer heap test: %lu heap faults\n", etimer_heap_faults);
+  printf("etimer heap test: %s\n",
+         missed == 0 && etimer_heap_faults == 0 ?
+         "passed" : "FAILED");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2015, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of uip_ds6_route_lookup() with a full routing table.
+ *
+ *         The routing table is filled with host routes and a few
+ *         shorter prefixes, and a mix of destinations is looked up.
+ *         Build once as is and once with e.g. "make HASH_SIZE=2048"
+ *         (after "make clean") to compare the list walk with the hash
+ *         index. The lookups are also checked against a longest-prefix
+ *         match over the whole route list.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NEIGHBORS 8
+#define LOOKUPS   200000UL
+
+PROCESS(route_lookup_bench_process, "Route lookup benchmark");
+AUTOSTART_PROCESSES(&route_lookup_bench_process);
+/*---------------------------------------------------------------------------*/
+static void
+nexthop_addr(uip_ipaddr_t *addr, int n)
+{
+  uip_ip6addr(addr, 0xfe80, 0, 0, 0, 0x0200, 0, 0, n + 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_neighbors(void)
+{
+  uip_ipaddr_t addr;
+  uip_lladdr_t lladdr;
+  int n;
+
+  for(n = 0; n < NEIGHBORS; n++) {
+    nexthop_addr(&addr, n);
+    memset(&lladdr, 0, sizeof(lladdr));
+    lladdr.addr[sizeof(lladdr) - 1] = n + 1;
+    uip_ds6_nbr_add(&addr, &lladdr, 1, NBR_REACHABLE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Pick a destination: mostly host routes, some addresses covered only
+   by a /64 or a /32 prefix, and some with no route at all */
+static void
+pick_destination(uip_ipaddr_t *addr, int hosts)
+{
+  uint16_t r = random_rand();
+
+  switch(r & 7) {
+  case 5:
+    uip_ip6addr(addr, 0xfd00, 0, 0, 1, 0, 0, 0, r);
+    break;
+  case 6:
+    uip_ip6addr(addr, 0xfd00, 1, r, 0, 0, 0, 0, 1);
+    break;
+  case 7:
+    uip_ip6addr(addr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, r);
+    break;
+  default:
+    uip_ip6addr(addr, 0xfd00, 0, 0, 0, 0, 0, 0x0100, (r >> 3) % hosts);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Longest-prefix match over the whole route list */
+static uip_ds6_route_t *
+reference_lookup(uip_ipaddr_t *addr)
+{
+  uip_ds6_route_t *r;
+  uip_ds6_route_t *found;
+
+  found = NULL;
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    if((found == NULL || r->length > found->length) &&
+       uip_ipaddr_prefixcmp(addr, &r->ipaddr, r->length)) {
+      found = r;
+    }
+  }
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(route_lookup_bench_process, ev, data)
+{
+  static uip_ipaddr_t addr, nexthop;
+  static unsigned long i, found, mismatches;
+  static clock_time_t start, elapsed;
+  uip_ds6_route_t *route;
+  int hosts;
+
+  PROCESS_BEGIN();
+
+  add_neighbors();
+
+  hosts = UIP_DS6_ROUTE_NB - 2;
+  for(i = 0; i < hosts; i++) {
+    uip_ip6addr(&addr, 0xfd00, 0, 0, 0, 0, 0, 0x0100, i);
+    nexthop_addr(&nexthop, i % NEIGHBORS);
+    uip_ds6_route_add(&addr, 128, &nexthop);
+  }
+  uip_ip6addr(&addr, 0xfd00, 0, 0, 1, 0, 0, 0, 0);
+  uip_ds6_route_add(&addr, 64, &nexthop);
+  uip_ip6addr(&addr, 0xfd00, 1, 0, 0, 0, 0, 0, 0);
+  uip_ds6_route_add(&addr, 32, &nexthop);
+
+  printf("%d routes, hash index size %d\n",
+         uip_ds6_route_num_routes(), UIP_DS6_ROUTE_HASH_SIZE);
+
+  /* Check the lookups against the reference, while host routes are
+     removed and added again as when they are refreshed */
+  random_init(1);
+  mismatches = 0;
+  for(i = 0; i < LOOKUPS / 100; i++) {
+    pick_destination(&addr, hosts);
+    route = uip_ds6_route_lookup(&addr);
+    if(route != reference_lookup(&addr)) {
+      mismatches++;
+    }
+    if(route != NULL && route->length == 128) {
+      uip_ds6_route_rm(route);
+      if(uip_ds6_route_lookup(&addr) != reference_lookup(&addr)) {
+        mismatches++;
+      }
+      nexthop_addr(&nexthop, i % NEIGHBORS);
+      uip_ds6_route_add(&addr, 128, &nexthop);
+    }
+  }
+  printf("%lu mismatches in %lu lookups\n", mismatches, i);
+
+  random_init(1);
+  found = 0;
+  start = clock_time();
+  for(i = 0; i < LOOKUPS; i++) {
+    pick_destination(&addr, hosts);
+    if(uip_ds6_route_lookup(&addr) != NULL) {
+      found++;
+    }
+  }
+  elapsed = clock_time() - start;
+
+  printf("%lu lookups (%lu found) in %lu ms\n", i, found,
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND));
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
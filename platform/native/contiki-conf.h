@@ -57,6 +57,70 @@ int select_set_callback(int fd, const struct select_callback *callback);
 #define CCIF
 #define CLIF
 
+#ifndef PROCESS_CONF_STATS
+#define PROCESS_CONF_STATS              1
+#endif /* PROCESS_CONF_STATS */
+#ifndef PROCESS_CONF_PRIORITIES
+#define PROCESS_CONF_PRIORITIES         1
+#endif /* PROCESS_CONF_PRIORITIES */
+#ifndef PROCESS_CONF_EVENT_STATS
+#define PROCESS_CONF_EVENT_STATS        1
+#endif /* PROCESS_CONF_EVENT_STATS */
+#ifndef PROCESS_CONF_SPILL_NUMEVENTS
+#define PROCESS_CONF_SPILL_NUMEVENTS    64
+#endif /* PROCESS_CONF_SPILL_NUMEVENTS */
+
+#ifndef MEMB_CONF_FREELIST
+#define MEMB_CONF_FREELIST              1
+#endif /* MEMB_CONF_FREELIST */
+#ifndef MEMB_CONF_STATS
+#define MEMB_CONF_STATS                 1
+#endif /* MEMB_CONF_STATS */
+
+#ifndef ETIMER_CONF_HEAP_SIZE
+#define ETIMER_CONF_HEAP_SIZE           256
+#endif /* ETIMER_CONF_HEAP_SIZE */
+#ifndef RTIMER_CONF_MULTIPLE
+#define RTIMER_CONF_MULTIPLE            1
+#endif /* RTIMER_CONF_MULTIPLE */
+#ifndef RTIMER_CONF_STATS
+#define RTIMER_CONF_STATS               1
+#endif /* RTIMER_CONF_STATS */
+
+#ifndef CTIMER_CONF_WHEEL_SIZE
+#define CTIMER_CONF_WHEEL_SIZE          64
+#endif /* CTIMER_CONF_WHEEL_SIZE */
+
+#ifndef RINGBUF_CONF_INDEX_TYPE
+#define RINGBUF_CONF_INDEX_TYPE         uint16_t
+#endif /* RINGBUF_CONF_INDEX_TYPE */
+#ifndef RINGBUF_CONF_BARRIER
+#define RINGBUF_CONF_BARRIER()          __sync_synchronize()
+#endif /* RINGBUF_CONF_BARRIER */
+#ifndef CRC16_CONF_SLICES
+#define CRC16_CONF_SLICES               8
+#endif /* CRC16_CONF_SLICES */
+
+/* Use AES-NI when the host has it, and the table-driven software
+   AES otherwise */
+#ifndef AES_128_CONF
+#define AES_128_CONF                    aes_128_ni_driver
+#endif /* AES_128_CONF */
+#ifndef AES_128_CONF_TABLES
+#define AES_128_CONF_TABLES             1
+#endif /* AES_128_CONF_TABLES */
+#ifndef AES_128_CONF_KEY_CACHE
+#define AES_128_CONF_KEY_CACHE          8
+#endif /* AES_128_CONF_KEY_CACHE */
+
+#ifndef ANTI_REPLAY_CONF_WINDOW
+#define ANTI_REPLAY_CONF_WINDOW         32
+#endif /* ANTI_REPLAY_CONF_WINDOW */
+
+#ifndef UIP_CONF_CHKSUM_WIDE
+#define UIP_CONF_CHKSUM_WIDE            1
+#endif /* UIP_CONF_CHKSUM_WIDE */
+
 /* These names are deprecated, use C99 names. */
 typedef uint8_t   u8_t;
 typedef uint16_t u16_t;
@@ -101,6 +165,10 @@ typedef unsigned short uip_stats_t;
 
 #define NETSTACK_CONF_NETWORK sicslowpan_driver
 
+#ifndef QUEUEBUF_CONF_SHARED
+#define QUEUEBUF_CONF_SHARED 1
+#endif /* QUEUEBUF_CONF_SHARED */
+
 #define UIP_CONF_ROUTER                 1
 
 #define SICSLOWPAN_CONF_COMPRESSION_IPV6        0
@@ -113,12 +181,27 @@ typedef unsigned short uip_stats_t;
 #endif /* SICSLOWPAN_CONF_FRAG */
 #define SICSLOWPAN_CONF_CONVENTIONAL_MAC	1
 #define SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS       2
+#ifndef SICSLOWPAN_CONF_REASS_CONTEXTS
+#define SICSLOWPAN_CONF_REASS_CONTEXTS          4
+#endif /* SICSLOWPAN_CONF_REASS_CONTEXTS */
+#ifndef SICSLOWPAN_CONF_REASS_STATS
+#define SICSLOWPAN_CONF_REASS_STATS             1
+#endif /* SICSLOWPAN_CONF_REASS_STATS */
 #ifndef SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS
 #define SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS   5
 #endif /* SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS */
 
 #define UIP_CONF_IPV6_CHECKS     1
 #define UIP_CONF_IPV6_QUEUE_PKT  1
+#ifndef UIP_PACKETQUEUE_CONF_NUM
+#define UIP_PACKETQUEUE_CONF_NUM 16
+#endif /* UIP_PACKETQUEUE_CONF_NUM */
+#ifndef UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#define UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE 4
+#endif /* UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE */
+#ifndef UIP_PACKETQUEUE_CONF_STATS
+#define UIP_PACKETQUEUE_CONF_STATS 1
+#endif /* UIP_PACKETQUEUE_CONF_STATS */
 #define UIP_CONF_IPV6_REASSEMBLY 0
 #define UIP_CONF_NETIF_MAX_ADDRESSES  3
 #define UIP_CONF_ND6_MAX_PREFIXES     3
@@ -129,6 +212,9 @@ typedef unsigned short uip_stats_t;
 #ifndef NBR_TABLE_CONF_MAX_NEIGHBORS
 #define NBR_TABLE_CONF_MAX_NEIGHBORS     30
 #endif /* NBR_TABLE_CONF_MAX_NEIGHBORS */
+#ifndef NBR_TABLE_CONF_HASH_SIZE
+#define NBR_TABLE_CONF_HASH_SIZE         64
+#endif /* NBR_TABLE_CONF_HASH_SIZE */
 #ifndef UIP_CONF_MAX_ROUTES
 #define UIP_CONF_MAX_ROUTES   30
 #endif /* UIP_CONF_MAX_ROUTES */
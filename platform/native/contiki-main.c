@@ -54,6 +54,7 @@
 
 #include "contiki.h"
 #include "net/netstack.h"
+#include "sys/idle.h"
 
 #include "ctk/ctk.h"
 #include "ctk/ctk-curses.h"
@@ -78,6 +79,38 @@
 #define SELECT_MAX 8
 #endif
 
+/* In tickless mode, the main loop sleeps in select() until the next
+   event, poll or timer deadline instead of waking up every
+   millisecond to poll the event timers. */
+#ifdef SELECT_CONF_TICKLESS
+#define SELECT_TICKLESS SELECT_CONF_TICKLESS
+#else
+#define SELECT_TICKLESS 1
+#endif
+
+/* The longest time to sleep in tickless mode, in clock ticks. */
+#ifdef SELECT_CONF_MAX_SLEEP
+#define SELECT_MAX_SLEEP SELECT_CONF_MAX_SLEEP
+#else
+#define SELECT_MAX_SLEEP CLOCK_SECOND
+#endif
+
+/* The main loop delivers up to SELECT_BATCH_EVENTS events, or runs
+   for at most SELECT_BATCH_TIME clock ticks, between each call to
+   select(). Set SELECT_CONF_BATCH_EVENTS to 1 to deliver a single
+   event per call, as process_run() does. */
+#ifdef SELECT_CONF_BATCH_EVENTS
+#define SELECT_BATCH_EVENTS SELECT_CONF_BATCH_EVENTS
+#else
+#define SELECT_BATCH_EVENTS 32
+#endif
+
+#ifdef SELECT_CONF_BATCH_TIME
+#define SELECT_BATCH_TIME SELECT_CONF_BATCH_TIME
+#else
+#define SELECT_BATCH_TIME (CLOCK_SECOND / 100)
+#endif
+
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
 
@@ -200,6 +233,15 @@ main(int argc, char **argv)
 #endif
 
   process_init();
+#if PROCESS_CONF_PRIORITIES
+  /* Serve the network stack, and the timers that drive the MAC and
+     RDC layers, before the applications */
+  process_set_priority(&etimer_process, PROCESS_PRIORITY_HIGH);
+  process_set_priority(&ctimer_process, PROCESS_PRIORITY_HIGH);
+#if NETSTACK_CONF_WITH_IPV6 || NETSTACK_CONF_WITH_IPV4
+  process_set_priority(&tcpip_process, PROCESS_PRIORITY_HIGH);
+#endif /* NETSTACK_CONF_WITH_IPV6 || NETSTACK_CONF_WITH_IPV4 */
+#endif /* PROCESS_CONF_PRIORITIES */
   process_start(&etimer_process, NULL);
   ctimer_init();
   rtimer_init();
@@ -255,11 +297,20 @@ main(int argc, char **argv)
     int i;
     int retval;
     struct timeval tv;
+#if SELECT_TICKLESS
+    clock_time_t timeout;
+#endif /* SELECT_TICKLESS */
 
-    retval = process_run();
+    retval = process_run_batch(SELECT_BATCH_EVENTS, SELECT_BATCH_TIME);
 
+#if SELECT_TICKLESS
+    timeout = retval ? 0 : idle_time_left(SELECT_MAX_SLEEP);
+    tv.tv_sec = timeout / CLOCK_SECOND;
+    tv.tv_usec = (timeout % CLOCK_SECOND) * 1000000 / CLOCK_SECOND;
+#else /* SELECT_TICKLESS */
     tv.tv_sec = 0;
     tv.tv_usec = retval ? 1 : 1000;
+#endif /* SELECT_TICKLESS */
 
     FD_ZERO(&fdr);
     FD_ZERO(&fdw);